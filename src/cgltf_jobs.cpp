@@ -1,6 +1,7 @@
 #include "cgltf_jobs.h"
 
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -51,7 +52,8 @@ JobSystem::JobResult make_error(const JobSystem::JobRequest& req, const std::str
     return result;
 }
 
-std::string copy_buffer_view(const cgltf_buffer_view* view)
+JobSystem::SharedBytes share_buffer_view(const std::shared_ptr<cgltf_data>& owner,
+                                         const cgltf_buffer_view* view)
 {
     if (!view) {
         return {};
@@ -65,7 +67,7 @@ std::string copy_buffer_view(const cgltf_buffer_view* view)
     if (!start || view->size == 0) {
         return {};
     }
-    return std::string(start, start + view->size);
+    return JobSystem::SharedBytes::view(owner, start, view->size);
 }
 
 const cgltf_attribute* find_attribute(const cgltf_attribute* attributes,
@@ -116,6 +118,10 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
         return make_error(req, message);
     }
 
+    // Embedded images alias the loaded buffers instead of copying them, so the
+    // parsed data stays alive for as long as any batch still references it.
+    std::shared_ptr<cgltf_data> owned(data, cgltf_free);
+
     auto result_data = std::make_unique<GltfMeshJobResult>();
     result_data->has_bounds = false;
     result_data->bounds_min[0] = result_data->bounds_min[1] = result_data->bounds_min[2] =
@@ -135,15 +141,12 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
                                                                   cgltf_attribute_type_texcoord, 0);
 
             if (!position_attr || !position_attr->data) {
-                cgltf_free(data);
                 return make_error(req, "gltf primitive missing position attribute");
             }
             if (!normal_attr || !normal_attr->data) {
-                cgltf_free(data);
                 return make_error(req, "gltf primitive missing normal attribute");
             }
             if (!texcoord_attr || !texcoord_attr->data) {
-                cgltf_free(data);
                 return make_error(req, "gltf primitive missing texcoord attribute");
             }
 
@@ -201,7 +204,6 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
             for (cgltf_size i = 0; i < draw_count; ++i) {
                 cgltf_size idx = indices_accessor ? indices[i] : i;
                 if (idx >= vertex_count) {
-                    cgltf_free(data);
                     return make_error(req, "gltf indices out of range");
                 }
                 const cgltf_size pos_offset = idx * 3;
@@ -218,20 +220,17 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
 
             const cgltf_material* material = prim.material;
             if (!material) {
-                cgltf_free(data);
                 return make_error(req, "gltf primitive missing material");
             }
 
             const cgltf_texture* texture = material->pbr_metallic_roughness.base_color_texture.texture;
             if (!texture || !texture->image) {
-                cgltf_free(data);
                 return make_error(req, "gltf material missing base color texture");
             }
 
             const cgltf_image* image = texture->image;
             std::optional<cgltf_size> image_index = index_of(image, data->images, data->images_count);
             if (!image_index) {
-                cgltf_free(data);
                 return make_error(req, "gltf texture image index out of range");
             }
 
@@ -241,18 +240,15 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
             if (image->uri) {
                 std::string uri(image->uri);
                 if (uri.rfind("data:", 0) == 0) {
-                    cgltf_free(data);
                     return make_error(req, "data: image URIs are not supported for gltf textures");
                 }
                 batch.image_uri = std::move(uri);
             } else if (image->buffer_view) {
-                batch.image_bytes = copy_buffer_view(image->buffer_view);
+                batch.image_bytes = share_buffer_view(owned, image->buffer_view);
                 if (batch.image_bytes.empty()) {
-                    cgltf_free(data);
                     return make_error(req, "gltf image buffer view missing data");
                 }
             } else {
-                cgltf_free(data);
                 return make_error(req, "gltf image missing uri or buffer view");
             }
 
@@ -260,8 +256,6 @@ JobSystem::JobResult build_mesh_batches(const JobSystem::JobRequest& req)
         }
     }
 
-    cgltf_free(data);
-
     JobSystem::JobResult result {};
     result.id = req.id;
     result.kind = req.kind;
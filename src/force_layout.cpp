@@ -1,16 +1,23 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <limits>
+#include <mutex>
+#include <random>
 #include <omp.h>
 #include <stdexcept>
+#include <type_traits>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include <utility>
 
+#include <glm/gtc/constants.hpp>
+
 #include "force_layout.h"
-#include "force_layout_quad_tree.hpp"
 
 namespace {
 
@@ -45,6 +52,139 @@ const glm::vec3& default_bounds_max() {
 
 } // namespace
 
+struct ForceLayoutSnapshot {
+    std::vector<glm::vec3> positions;
+    std::tuple<double, double, double> results {0.0, 0.0, 0.0};
+    uint64_t applied = 0;   // last command applied before this snapshot
+    bool stabilized = false;
+};
+
+// Owns a private ForceLayout and iterates it on its own thread while it is
+// active. Snapshots are triple buffered: the worker fills `back`, swaps it
+// with `ready`, and the owner swaps `ready` with `front` when it polls.
+class ForceLayoutWorker {
+public:
+    using Command = std::function<void(ForceLayout&)>;
+    using Replay = std::function<void(std::vector<glm::vec3>&)>;
+
+    explicit ForceLayoutWorker(ForceLayout simulation)
+        : sim(std::move(simulation)) {
+        front.positions = sim.positions;
+        thread = std::thread([this]() { run(); });
+    }
+
+    ~ForceLayoutWorker() {
+        finish();
+    }
+
+    uint64_t submit(Command command) {
+        uint64_t seq = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            seq = nextSeq++;
+            commands.emplace_back(seq, std::move(command));
+        }
+        cv.notify_one();
+        return seq;
+    }
+
+    bool poll() {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (!fresh) {
+            return false;
+        }
+        std::swap(front, ready);
+        fresh = false;
+        return true;
+    }
+
+    // Stops the thread after every queued command has been applied and hands
+    // back the simulation.
+    ForceLayout finish() {
+        if (thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_one();
+            thread.join();
+        }
+        return std::move(sim);
+    }
+
+    // Owner-thread state.
+    ForceLayoutSnapshot front;
+    std::deque<std::pair<uint64_t, Replay>> replays;
+    uint64_t startSeq = 0;
+    std::tuple<double, double, double, double, double, double, double, double, double> sentParams {};
+
+private:
+    ForceLayout sim;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<uint64_t, Command>> commands;
+    uint64_t nextSeq = 1;
+    bool stopping = false;
+
+    std::mutex snapshotMutex;
+    ForceLayoutSnapshot back;
+    ForceLayoutSnapshot ready;
+    bool fresh = false;
+
+    void run() {
+        uint64_t applied = 0;
+        bool settled = false;
+        std::deque<std::pair<uint64_t, Command>> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stopping || !commands.empty() || sim.active; });
+                if (stopping && commands.empty()) {
+                    return;
+                }
+                batch.swap(commands);
+            }
+            for (auto& entry : batch) {
+                try {
+                    entry.second(sim);
+                } catch (const std::exception& e) {
+                    std::cerr << "[ForceLayout] background command failed: " << e.what() << std::endl;
+                }
+                applied = entry.first;
+            }
+            batch.clear();
+
+            if (sim.active) {
+                settled = false;
+                try {
+                    sim.step(1);
+                } catch (const std::exception& e) {
+                    std::cerr << "[ForceLayout] background step failed: " << e.what() << std::endl;
+                    sim.active = false;
+                }
+                double average = std::get<1>(sim.last_results);
+                double max_d = std::get<2>(sim.last_results);
+                if (average < sim.stabilized_avg_displacement && max_d < sim.stabilized_max_displacement) {
+                    sim.active = false;
+                    settled = true;
+                }
+            }
+            publish(applied, settled);
+        }
+    }
+
+    void publish(uint64_t applied, bool settled) {
+        back.positions.assign(sim.positions.begin(), sim.positions.end());
+        back.results = sim.last_results;
+        back.applied = applied;
+        back.stabilized = settled;
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        std::swap(back, ready);
+        fresh = true;
+    }
+};
+
 int ForceLayoutSignal::connect(const sol::function& callback) {
     sol::protected_function fn = callback;
     int id = nextId++;
@@ -147,7 +287,7 @@ ForceLayout::ForceLayout(const glm::vec3& center_position_,
       stabilized_avg_displacement(stabilized_avg_displacement_),
       max_displacement_squared(max_displacement_squared_),
       update_interval(update_interval_),
-      center_position(center_position_.x, center_position_.y),
+      center_position(center_position_),
       bounds_min(bounds_min_),
       bounds_max(bounds_max_),
       auto_center_within_bounds(auto_center_within_bounds_) {
@@ -155,169 +295,211 @@ ForceLayout::ForceLayout(const glm::vec3& center_position_,
     clear();
 }
 
+ForceLayout::ForceLayout(ForceLayout&&) noexcept = default;
+ForceLayout& ForceLayout::operator=(ForceLayout&&) noexcept = default;
+
+ForceLayout::~ForceLayout() = default;
+
 void ForceLayout::clear() {
     positions.clear();
-    edges.clear();
+    springs.clear();
+    springs_dirty = true;
     pinned.clear();
-    forces.clear();
     last_results = std::make_tuple(0.0, 0.0, 0.0);
     active = false;
     callback = sol::nil;
+    post_to_worker([](ForceLayout& sim) { sim.clear(); },
+                   [](std::vector<glm::vec3>& p) { p.clear(); });
 }
 
 int ForceLayout::add_node(const glm::vec3& pos) {
     size_t idx = positions.size();
     assert_valid_position(pos, "add_node", idx);
-    positions.push_back(clamp_to_bounds(pos));
-    edges.emplace_back();
-    pinned.push_back(false);
-    forces.emplace_back(0.0);
+    glm::vec3 clamped = clamp_to_bounds(pos);
+    positions.push_back(clamped);
+    pinned.push_back(0);
+    springs_dirty = true;
+    post_to_worker([clamped](ForceLayout& sim) { sim.add_node(clamped); },
+                   [clamped](std::vector<glm::vec3>& p) { p.push_back(clamped); });
     return static_cast<int>(idx);
 }
 
 void ForceLayout::add_edge(int source, int target, bool mirror) {
     if (source < 0 || target < 0) return;
-    if (static_cast<size_t>(source) >= edges.size() || static_cast<size_t>(target) >= edges.size()) return;
-    edges[static_cast<size_t>(source)].push_back(target);
-    if (mirror) edges[static_cast<size_t>(target)].push_back(source);
+    if (static_cast<size_t>(source) >= positions.size() || static_cast<size_t>(target) >= positions.size()) return;
+    // A spring acts once per directed entry pointing to a higher index, so an
+    // unmirrored edge from a higher to a lower index exerts no force.
+    if (target > source) {
+        springs.emplace_back(source, target);
+    }
+    if (mirror && source > target) {
+        springs.emplace_back(target, source);
+    }
+    springs_dirty = true;
+    post_to_worker([source, target, mirror](ForceLayout& sim) { sim.add_edge(source, target, mirror); });
 }
 
 void ForceLayout::set_position(int idx, const glm::vec3& pos) {
     if (idx < 0 || static_cast<size_t>(idx) >= positions.size()) return;
     assert_valid_position(pos, "set_position", static_cast<size_t>(idx));
-    positions[static_cast<size_t>(idx)] = clamp_to_bounds(pos);
+    glm::vec3 clamped = clamp_to_bounds(pos);
+    positions[static_cast<size_t>(idx)] = clamped;
+    size_t index = static_cast<size_t>(idx);
+    post_to_worker([idx, clamped](ForceLayout& sim) { sim.set_position(idx, clamped); },
+                   [index, clamped](std::vector<glm::vec3>& p) {
+                       if (index < p.size()) p[index] = clamped;
+                   });
 }
 
 void ForceLayout::pin_node(int idx, bool value) {
     if (idx < 0 || static_cast<size_t>(idx) >= pinned.size()) return;
-    pinned[static_cast<size_t>(idx)] = value;
+    pinned[static_cast<size_t>(idx)] = value ? 1 : 0;
+    post_to_worker([idx, value](ForceLayout& sim) { sim.pin_node(idx, value); });
 }
 
 std::tuple<double, double, double> ForceLayout::step(int num_iterations) {
-    size_t n = positions.size();
-    if (n == 0) {
+    if (worker) {
+        throw std::runtime_error("ForceLayout.step is unavailable in background mode; use update");
+    }
+    if (positions.empty()) {
         last_results = std::make_tuple(0.0, 0.0, 0.0);
         return last_results;
     }
+    if (dimensions == 3) {
+        return run_iterations(scratch3d, num_iterations);
+    }
+    return run_iterations(scratch2d, num_iterations);
+}
 
-    std::vector<glm::dvec2> xy_positions(n);
+void ForceLayout::rebuild_springs() {
+    const size_t n = positions.size();
+    spring_offsets.assign(n + 1, 0);
+    for (const auto& [a, b] : springs) {
+        ++spring_offsets[static_cast<size_t>(a) + 1];
+        ++spring_offsets[static_cast<size_t>(b) + 1];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        spring_offsets[i + 1] += spring_offsets[i];
+    }
+    spring_targets.resize(springs.size() * 2);
+    std::vector<int> cursor(spring_offsets.begin(), spring_offsets.end() - 1);
+    for (const auto& [a, b] : springs) {
+        spring_targets[static_cast<size_t>(cursor[static_cast<size_t>(a)]++)] = b;
+        spring_targets[static_cast<size_t>(cursor[static_cast<size_t>(b)]++)] = a;
+    }
+    springs_dirty = false;
+}
+
+template <typename Vec>
+std::tuple<double, double, double> ForceLayout::run_iterations(ForceLayoutScratch<Vec>& scratch,
+                                                               int num_iterations) {
+    constexpr int dims = ForceLayoutScratch<Vec>::kDims;
+    const size_t n = positions.size();
+    const int count = static_cast<int>(n);
+    if (springs_dirty) {
+        rebuild_springs();
+    }
+
+    // Positions are validated on the way in and out of the iteration loop;
+    // inside it they are only ever moved by clamped, bounded displacements.
     for (size_t i = 0; i < n; ++i) {
         assert_valid_position(positions[i], "step:pre", i);
         positions[i] = clamp_to_bounds(positions[i]);
-        xy_positions[i] = glm::dvec2(positions[i].x, positions[i].y);
     }
 
-    for (int iter = 0; iter < num_iterations; ++iter) {
-        forces.assign(n, glm::dvec2(0.0));
-
-        // Compute bounds for quadtree
-        glm::dvec2 minPos = xy_positions[0];
-        glm::dvec2 maxPos = xy_positions[0];
-        for (size_t i = 1; i < n; ++i) {
-            minPos = glm::min(minPos, xy_positions[i]);
-            maxPos = glm::max(maxPos, xy_positions[i]);
-        }
-        glm::dvec2 center = (minPos + maxPos) * 0.5;
-        glm::dvec2 extent = maxPos - minPos;
-        double maxDim = std::max(extent.x, extent.y) * 0.5 + 1.0;
-
-        // Build quadtree
-        QuadTreeNode tree(center, maxDim <= 0.0 ? 1.0 : maxDim);
+    std::array<double*, dims> pos;
+    std::array<double*, dims> force;
+    std::array<double, dims> center;
+    std::array<double, dims> lo;
+    std::array<double, dims> hi;
+    for (int d = 0; d < dims; ++d) {
+        const size_t axis = static_cast<size_t>(d);
+        scratch.positions[axis].resize(n);
+        scratch.forces[axis].resize(n);
+        pos[axis] = scratch.positions[axis].data();
+        force[axis] = scratch.forces[axis].data();
         for (size_t i = 0; i < n; ++i) {
-            tree.insert(static_cast<int>(i), xy_positions[i], xy_positions);
-        }
-        tree.finalizeMass();
-
-        // Repulsive forces (Barnes-Hut)
-        std::vector<std::vector<glm::dvec2>> local_forces;
-        int num_threads = omp_get_max_threads();
-        local_forces.resize(static_cast<size_t>(num_threads), std::vector<glm::dvec2>(n, glm::dvec2(0.0)));
-
-#pragma omp parallel
-        {
-            int tid = omp_get_thread_num();
-            auto& local = local_forces[static_cast<size_t>(tid)];
-
-#pragma omp for
-            for (int i = 0; i < static_cast<int>(n); ++i) {
-                tree.computeRepulsion(i, xy_positions[static_cast<size_t>(i)], local[static_cast<size_t>(i)],
-                                      xy_positions, 0.5, repulsive_force_constant);
-            }
+            pos[axis][i] = positions[i][d];
         }
+        center[axis] = center_position[d];
+        lo[axis] = bounds_min[d];
+        hi[axis] = bounds_max[d];
+    }
 
-        std::fill(forces.begin(), forces.end(), glm::dvec2(0.0));
-        for (int t = 0; t < num_threads; ++t) {
-            auto& local = local_forces[static_cast<size_t>(t)];
-            for (size_t i = 0; i < n; ++i) {
-                forces[i] += local[i];
-            }
-        }
+    const int* offsets = spring_offsets.data();
+    const int* targets = spring_targets.data();
+    const uint8_t* fixed = pinned.data();
+    const double rest = spring_rest_length;
+    const double stiffness = spring_constant;
+    const double centering = center_force;
+    const double dt = delta_t;
+    const double max_sq = max_displacement_squared;
 
-        // Attractive (spring) forces
-        for (size_t i = 0; i < n; ++i) {
-            glm::dvec2 pi = xy_positions[i];
-            for (int j : edges[i]) {
-                if (static_cast<size_t>(j) <= i) {
-                    continue;
-                }
-                glm::dvec2 pj = xy_positions[static_cast<size_t>(j)];
-                glm::dvec2 delta = pi - pj;
+    for (int iter = 0; iter < num_iterations; ++iter) {
+        scratch.tree.build(scratch.positions);
+
+        // Repulsion (Barnes-Hut) plus springs. The CSR adjacency is
+        // symmetric, so each node gathers its own spring forces and no two
+        // threads write the same entry.
+#pragma omp parallel for schedule(dynamic, 256)
+        for (int i = 0; i < count; ++i) {
+            const size_t self = static_cast<size_t>(i);
+            const Vec pi = ForceLayoutTree<Vec>::point(scratch.positions, self);
+            Vec f = scratch.tree.repulsion(i, pi, 0.5, repulsive_force_constant);
+            for (int e = offsets[i]; e < offsets[i + 1]; ++e) {
+                const size_t other = static_cast<size_t>(targets[e]);
+                Vec delta = pi - ForceLayoutTree<Vec>::point(scratch.positions, other);
                 double dist = glm::length(delta);
                 if (dist == 0.0) continue;
-
-                double force_mag = spring_constant * (dist - spring_rest_length);
-                glm::dvec2 f = force_mag * (delta / dist);
-
-                forces[i] -= f;
-                forces[static_cast<size_t>(j)] += f;
+                f -= (stiffness * (dist - rest) / dist) * delta;
+            }
+            for (int d = 0; d < dims; ++d) {
+                force[static_cast<size_t>(d)][self] = f[d];
             }
         }
 
-        // Centering force
-        for (size_t i = 0; i < n; ++i) {
-            glm::dvec2 diff = center_position - xy_positions[i];
-            glm::dvec2 center_force_vec = center_force * diff * glm::abs(diff);
-            forces[i] += center_force_vec;
-        }
-
-        // Integrate forces and update positions
+        // Centering and integration. Infinite bounds clamp to the value itself.
         double total = 0.0;
         double max_d = 0.0;
-        for (size_t i = 0; i < n; ++i) {
-            if (pinned[i]) {
-                positions[i] = clamp_to_bounds(positions[i]);
-                xy_positions[i] = glm::dvec2(positions[i].x, positions[i].y);
-                continue;
+#pragma omp parallel for reduction(+ : total) reduction(max : max_d)
+        for (int i = 0; i < count; ++i) {
+            if (fixed[i]) continue;
+            std::array<double, dims> disp;
+            double disp_sq = 0.0;
+            for (int d = 0; d < dims; ++d) {
+                const size_t axis = static_cast<size_t>(d);
+                double diff = center[axis] - pos[axis][i];
+                disp[axis] = dt * (force[axis][i] + centering * diff * std::abs(diff));
+                disp_sq += disp[axis] * disp[axis];
             }
-
-            glm::dvec2 disp = delta_t * forces[i];
-            double disp_sq = glm::dot(disp, disp);
-            double scale = 1.0;
-            if (disp_sq > max_displacement_squared) {
-                scale = std::sqrt(max_displacement_squared / disp_sq);
+            double scale = disp_sq > max_sq ? std::sqrt(max_sq / disp_sq) : 1.0;
+            for (int d = 0; d < dims; ++d) {
+                const size_t axis = static_cast<size_t>(d);
+                pos[axis][i] = std::min(std::max(pos[axis][i] + disp[axis] * scale, lo[axis]), hi[axis]);
             }
-
-            glm::dvec2 delta = disp * scale;
-            positions[i].x += delta.x;
-            positions[i].y += delta.y;
-            positions[i] = clamp_to_bounds(positions[i]);
-            assert_valid_position(positions[i], "step:post", i);
-            xy_positions[i] = glm::dvec2(positions[i].x, positions[i].y);
-
-            double dist = glm::length(delta);
+            double dist = std::sqrt(disp_sq) * scale;
             total += dist;
-            if (dist > max_d) {
-                max_d = dist;
-            }
+            max_d = std::max(max_d, dist);
         }
 
         last_results = std::make_tuple(total, total / static_cast<double>(n), max_d);
     }
 
+    for (size_t i = 0; i < n; ++i) {
+        for (int d = 0; d < dims; ++d) {
+            positions[i][d] = static_cast<float>(pos[static_cast<size_t>(d)][i]);
+        }
+        assert_valid_position(positions[i], "step:post", i);
+    }
+
     return last_results;
 }
 
 std::tuple<double, double, double> ForceLayout::update(int num_iterations) {
+    if (worker) {
+        sync_worker();
+        return last_results;
+    }
     if (!active) {
         return last_results;
     }
@@ -338,16 +520,21 @@ void ForceLayout::start(sol::optional<sol::function> callback_) {
         callback = sol::nil;
     }
     active = true;
+    if (worker) {
+        worker->startSeq = worker->submit([](ForceLayout& sim) { sim.active = true; });
+    }
     emit_changed();
 }
 
 void ForceLayout::cancel() {
     active = false;
+    post_to_worker([](ForceLayout& sim) { sim.active = false; });
     emit_changed();
 }
 
 void ForceLayout::stop() {
     active = false;
+    post_to_worker([](ForceLayout& sim) { sim.active = false; });
     if (callback.valid()) {
         sol::protected_function fn = callback;
         sol::protected_function_result result = fn();
@@ -372,6 +559,9 @@ void ForceLayout::until_stable(int iterations_per_update, double timeout_seconds
     start();
     while (active) {
         update(iterations_per_update);
+        if (worker) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
         auto elapsed = std::chrono::steady_clock::now() - start_time;
         double seconds = std::chrono::duration<double>(elapsed).count();
         if (seconds > timeout_seconds) {
@@ -394,11 +584,12 @@ const glm::vec3& ForceLayout::position_at(size_t index) const {
 }
 
 void ForceLayout::set_center_position(const glm::vec3& pos) {
-    center_position = glm::dvec2(pos.x, pos.y);
+    center_position = glm::dvec3(pos);
+    post_to_worker([pos](ForceLayout& sim) { sim.set_center_position(pos); });
 }
 
 glm::vec3 ForceLayout::get_center_position() const {
-    return glm::vec3(center_position, 0.0);
+    return glm::vec3(center_position);
 }
 
 void ForceLayout::set_bounds(const glm::vec3& min, const glm::vec3& max) {
@@ -410,6 +601,12 @@ void ForceLayout::set_bounds(const glm::vec3& min, const glm::vec3& max) {
         pos = clamp_to_bounds(pos);
     }
     refresh_center_from_bounds();
+    post_to_worker([min, max](ForceLayout& sim) { sim.set_bounds(min, max); },
+                   [this](std::vector<glm::vec3>& p) {
+                       for (auto& pos : p) {
+                           pos = clamp_to_bounds(pos);
+                       }
+                   });
 }
 
 void ForceLayout::set_bounds(const std::pair<glm::vec3, glm::vec3>& bounds) {
@@ -423,6 +620,7 @@ std::pair<glm::vec3, glm::vec3> ForceLayout::get_bounds() const {
 void ForceLayout::set_auto_center_within_bounds(bool enabled) {
     auto_center_within_bounds = enabled;
     refresh_center_from_bounds();
+    post_to_worker([enabled](ForceLayout& sim) { sim.set_auto_center_within_bounds(enabled); });
 }
 
 bool ForceLayout::get_auto_center_within_bounds() const {
@@ -449,6 +647,111 @@ size_t ForceLayout::node_count() const {
     return positions.size();
 }
 
+void ForceLayout::set_dimensions(int value) {
+    if (value != 2 && value != 3) {
+        throw std::runtime_error("ForceLayout dimensions must be 2 or 3");
+    }
+    dimensions = value;
+    post_to_worker([value](ForceLayout& sim) { sim.set_dimensions(value); });
+}
+
+int ForceLayout::get_dimensions() const {
+    return dimensions;
+}
+
+void ForceLayout::set_background(bool enabled) {
+    if (enabled == static_cast<bool>(worker)) {
+        return;
+    }
+    if (enabled) {
+        worker = std::make_unique<ForceLayoutWorker>(simulation_copy());
+        worker->sentParams = std::make_tuple(spring_rest_length, repulsive_force_constant, spring_constant,
+                                             delta_t, center_force, stabilized_max_displacement,
+                                             stabilized_avg_displacement, max_displacement_squared,
+                                             update_interval);
+        return;
+    }
+    ForceLayout sim = worker->finish();
+    worker.reset();
+    positions = std::move(sim.positions);
+    last_results = sim.last_results;
+}
+
+bool ForceLayout::get_background() const {
+    return static_cast<bool>(worker);
+}
+
+ForceLayout ForceLayout::simulation_copy() const {
+    ForceLayout sim(glm::vec3(center_position),
+                    spring_rest_length,
+                    repulsive_force_constant,
+                    spring_constant,
+                    delta_t,
+                    center_force,
+                    stabilized_max_displacement,
+                    stabilized_avg_displacement,
+                    max_displacement_squared,
+                    update_interval,
+                    glm::vec3(bounds_min),
+                    glm::vec3(bounds_max),
+                    auto_center_within_bounds);
+    sim.center_position = center_position;
+    sim.dimensions = dimensions;
+    sim.positions = positions;
+    sim.springs = springs;
+    sim.pinned = pinned;
+    sim.last_results = last_results;
+    sim.active = active;
+    return sim;
+}
+
+void ForceLayout::post_to_worker(std::function<void(ForceLayout&)> apply,
+                                 std::function<void(std::vector<glm::vec3>&)> replay) {
+    if (!worker) {
+        return;
+    }
+    uint64_t seq = worker->submit(std::move(apply));
+    if (replay) {
+        worker->replays.emplace_back(seq, std::move(replay));
+    }
+}
+
+void ForceLayout::sync_worker() {
+    auto params = std::make_tuple(spring_rest_length, repulsive_force_constant, spring_constant,
+                                  delta_t, center_force, stabilized_max_displacement,
+                                  stabilized_avg_displacement, max_displacement_squared,
+                                  update_interval);
+    if (params != worker->sentParams) {
+        worker->sentParams = params;
+        worker->submit([params](ForceLayout& sim) {
+            std::tie(sim.spring_rest_length, sim.repulsive_force_constant, sim.spring_constant,
+                     sim.delta_t, sim.center_force, sim.stabilized_max_displacement,
+                     sim.stabilized_avg_displacement, sim.max_displacement_squared,
+                     sim.update_interval) = params;
+        });
+    }
+
+    if (!worker->poll()) {
+        return;
+    }
+    const ForceLayoutSnapshot& snapshot = worker->front;
+    auto& replays = worker->replays;
+    while (!replays.empty() && replays.front().first <= snapshot.applied) {
+        replays.pop_front();
+    }
+    // Edits the worker has not seen yet stay visible on top of its snapshot.
+    positions = snapshot.positions;
+    for (auto& entry : replays) {
+        entry.second(positions);
+    }
+    last_results = snapshot.results;
+
+    if (active && snapshot.stabilized && snapshot.applied >= worker->startSeq) {
+        stop();
+        emit_stabilized();
+    }
+}
+
 void ForceLayout::emit_changed() {
     changed.emit();
 }
@@ -462,13 +765,16 @@ void ForceLayout::refresh_center_from_bounds() {
         return;
     }
 
-    glm::dvec2 new_center = center_position;
+    glm::dvec3 new_center = center_position;
     if (std::isfinite(bounds_min.x) && std::isfinite(bounds_max.x)) {
         new_center.x = (bounds_min.x + bounds_max.x) * 0.5;
     }
     if (std::isfinite(bounds_min.y) && std::isfinite(bounds_max.y)) {
         new_center.y = (bounds_min.y + bounds_max.y) * 0.5;
     }
+    if (std::isfinite(bounds_min.z) && std::isfinite(bounds_max.z)) {
+        new_center.z = (bounds_min.z + bounds_max.z) * 0.5;
+    }
     center_position = new_center;
 }
 
@@ -494,3 +800,46 @@ glm::vec3 ForceLayout::clamp_to_bounds(const glm::vec3& pos) const {
     }
     return clamped;
 }
+
+ForceLayoutBenchmark benchmark_force_layout(size_t node_count, int dimensions, double min_seconds) {
+    const float inf = std::numeric_limits<float>::infinity();
+    ForceLayout layout;
+    layout.set_dimensions(dimensions);
+    layout.set_bounds(glm::vec3(-inf), glm::vec3(inf));
+
+    // A random spanning tree plus half as many extra edges, spread over a
+    // disc sized so the initial density does not depend on node_count.
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const double radius = std::sqrt(static_cast<double>(node_count)) * layout.spring_rest_length;
+    for (size_t i = 0; i < node_count; ++i) {
+        double r = radius * std::sqrt(unit(rng));
+        double angle = glm::two_pi<double>() * unit(rng);
+        double z = dimensions == 3 ? radius * (unit(rng) - 0.5) : 0.0;
+        layout.add_node(glm::vec3(r * std::cos(angle), r * std::sin(angle), z));
+    }
+    ForceLayoutBenchmark result;
+    result.nodes = node_count;
+    if (node_count < 2) {
+        return result;
+    }
+    for (size_t i = 1; i < node_count; ++i) {
+        std::uniform_int_distribution<size_t> parent(0, i - 1);
+        layout.add_edge(static_cast<int>(i), static_cast<int>(parent(rng)));
+    }
+    std::uniform_int_distribution<size_t> any(0, node_count - 1);
+    for (size_t i = 0; i < node_count / 2; ++i) {
+        layout.add_edge(static_cast<int>(any(rng)), static_cast<int>(any(rng)));
+    }
+    result.edges = node_count - 1 + node_count / 2;
+
+    layout.step(1); // warm up scratch buffers and the CSR adjacency
+    auto start = std::chrono::steady_clock::now();
+    do {
+        layout.step(1);
+        ++result.iterations;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (result.seconds < min_seconds);
+    result.iterations_per_second = result.iterations / result.seconds;
+    return result;
+}
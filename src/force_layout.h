@@ -2,10 +2,16 @@
 
 #include <sol/sol.hpp>
 #include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "force_layout_tree.hpp"
+
 class ForceLayoutSignal {
 public:
     int connect(const sol::function& callback);
@@ -19,6 +25,30 @@ private:
     std::vector<std::pair<int, sol::protected_function>> callbacks;
 };
 
+// Per-dimension working set reused across ForceLayout::step calls. Positions
+// and forces are stored one array per axis so the per-node passes vectorize.
+template <typename Vec>
+struct ForceLayoutScratch {
+    static constexpr int kDims = ForceLayoutTree<Vec>::kDims;
+    std::array<std::vector<double>, kDims> positions;
+    std::array<std::vector<double>, kDims> forces;
+    ForceLayoutTree<Vec> tree;
+};
+
+struct ForceLayoutBenchmark {
+    size_t nodes = 0;
+    size_t edges = 0;
+    int iterations = 0;
+    double seconds = 0.0;
+    double iterations_per_second = 0.0;
+};
+
+// Steps a synthetic random graph of node_count nodes for at least
+// min_seconds of wall time and reports the throughput.
+ForceLayoutBenchmark benchmark_force_layout(size_t node_count, int dimensions = 2, double min_seconds = 1.0);
+
+class ForceLayoutWorker;
+
 class ForceLayout {
 public:
     ForceLayout();
@@ -45,6 +75,9 @@ public:
                 const glm::vec3& bounds_min,
                 const glm::vec3& bounds_max,
                 bool auto_center_within_bounds = true);
+    ForceLayout(ForceLayout&&) noexcept;
+    ForceLayout& operator=(ForceLayout&&) noexcept;
+    ~ForceLayout();
 
     void clear();
     int add_node(const glm::vec3& pos);
@@ -73,6 +106,15 @@ public:
     ForceLayoutSignal& stabilized_signal();
     bool is_active() const;
     size_t node_count() const;
+    // 2 lays nodes out in XY (z is left untouched); 3 also spreads them in depth.
+    void set_dimensions(int value);
+    int get_dimensions() const;
+    // Runs the simulation continuously on a worker thread. Edits are queued
+    // and applied between iterations; update() picks up the latest published
+    // positions and fires the signals on the calling thread. step() is not
+    // available in this mode.
+    void set_background(bool enabled);
+    bool get_background() const;
 
     double spring_rest_length;
     double repulsive_force_constant;
@@ -85,16 +127,26 @@ public:
     double update_interval;
 
 private:
-    glm::dvec2 center_position;
+    friend class ForceLayoutWorker;
+
+    glm::dvec3 center_position;
     glm::dvec3 bounds_min;
     glm::dvec3 bounds_max;
     bool auto_center_within_bounds = true;
     bool active = false;
+    int dimensions = 2;
 
-    std::vector<std::vector<int>> edges;
+    // Each spring is stored once as an (a, b) pair and expanded into a
+    // symmetric CSR adjacency before the next step.
+    std::vector<std::pair<int, int>> springs;
+    std::vector<int> spring_offsets;
+    std::vector<int> spring_targets;
+    bool springs_dirty = true;
     std::vector<glm::vec3> positions;
-    std::vector<bool> pinned;
-    std::vector<glm::dvec2> forces;
+    std::vector<uint8_t> pinned;
+    ForceLayoutScratch<glm::dvec2> scratch2d;
+    ForceLayoutScratch<glm::dvec3> scratch3d;
+    std::unique_ptr<ForceLayoutWorker> worker;
     std::tuple<double, double, double> last_results {0.0, 0.0, 0.0};
 
     sol::function callback;
@@ -102,6 +154,13 @@ private:
     ForceLayoutSignal changed;
     ForceLayoutSignal stabilized;
 
+    template <typename Vec>
+    std::tuple<double, double, double> run_iterations(ForceLayoutScratch<Vec>& scratch, int num_iterations);
+    void rebuild_springs();
+    ForceLayout simulation_copy() const;
+    void post_to_worker(std::function<void(ForceLayout&)> apply,
+                        std::function<void(std::vector<glm::vec3>&)> replay = nullptr);
+    void sync_worker();
     void emit_changed();
     void emit_stabilized();
     void refresh_center_from_bounds();
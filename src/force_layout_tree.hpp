@@ -0,0 +1,229 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Barnes-Hut tree stored as a flat pre-order array.
+//
+// Points are sorted by Morton code, so every cell owns a contiguous range of
+// the sorted points and its children follow it directly in the node array.
+// Each node records `skip`, the index just past its subtree, which lets
+// repulsion walk the tree without a stack. All storage is reused between
+// builds. Vec is glm::dvec2 (quadtree) or glm::dvec3 (octree).
+template <typename Vec>
+class ForceLayoutTree {
+public:
+    static constexpr int kDims = std::is_same<Vec, glm::dvec3>::value ? 3 : 2;
+    static_assert(kDims == 3 || std::is_same<Vec, glm::dvec2>::value,
+                  "ForceLayoutTree supports glm::dvec2 and glm::dvec3");
+
+    struct Node {
+        Vec massCenter;
+        double mass = 0.0;
+        double size = 0.0;   // edge length of the cubic cell
+        int32_t skip = 0;    // next node after this subtree
+        int32_t begin = 0;   // range in the Morton-sorted points
+        int32_t end = 0;
+        bool leaf = true;
+    };
+
+    static constexpr int kLeafCapacity = 8;
+    static constexpr int kMaxDepth = 21; // 21 bits per axis fit a 63-bit code
+
+    // Builds from structure-of-arrays coordinates, one vector per axis.
+    void build(const std::array<std::vector<double>, kDims>& axes) {
+        nodes.clear();
+        order.clear();
+        points.clear();
+        ids.clear();
+        const size_t n = axes[0].size();
+        if (n == 0) {
+            return;
+        }
+
+        Vec minPos = point(axes, 0);
+        Vec maxPos = minPos;
+        for (size_t i = 1; i < n; ++i) {
+            Vec p = point(axes, i);
+            minPos = glm::min(minPos, p);
+            maxPos = glm::max(maxPos, p);
+        }
+        Vec extent = maxPos - minPos;
+        double size = std::max(extent.x, extent.y);
+        if constexpr (kDims == 3) {
+            size = std::max(size, extent.z);
+        }
+        size += 2.0;
+        Vec origin = (minPos + maxPos) * 0.5 - Vec(size * 0.5);
+
+        const double cells = static_cast<double>(1u << kMaxDepth);
+        const double scale = cells / size;
+        order.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            Vec local = (point(axes, i) - origin) * scale;
+            uint64_t code = spread(quantize(local.x, cells))
+                          | (spread(quantize(local.y, cells)) << 1);
+            if constexpr (kDims == 3) {
+                code |= spread(quantize(local.z, cells)) << 2;
+            }
+            order.emplace_back(code, static_cast<int32_t>(i));
+        }
+        std::sort(order.begin(), order.end());
+
+        points.reserve(n);
+        ids.reserve(n);
+        for (const auto& entry : order) {
+            points.push_back(point(axes, static_cast<size_t>(entry.second)));
+            ids.push_back(entry.second);
+        }
+
+        buildNode(0, static_cast<int32_t>(n), 0, size);
+    }
+
+    Vec repulsion(int32_t index,
+                  const Vec& pos,
+                  double theta,
+                  double repulsiveConstant,
+                  double jitterAmount = 60.0) const {
+        Vec force(0.0);
+        const int32_t count = static_cast<int32_t>(nodes.size());
+        int32_t k = 0;
+        while (k < count) {
+            const Node& node = nodes[static_cast<size_t>(k)];
+            Vec delta = pos - node.massCenter;
+            double distSq = glm::dot(delta, delta) + 1e-9; // avoid division by zero
+            double dist = std::sqrt(distSq);
+            // A cell containing pos is never far enough for theta < 1/sqrt(3),
+            // so the approximation never includes the point itself.
+            if ((node.size / dist) < theta) {
+                double rep = repulsiveConstant * node.mass / distSq;
+                force += rep * (delta / dist);
+                k = node.skip;
+                continue;
+            }
+            if (!node.leaf) {
+                ++k;
+                continue;
+            }
+            for (int32_t p = node.begin; p < node.end; ++p) {
+                const int32_t other = ids[static_cast<size_t>(p)];
+                if (other == index) continue;
+                Vec d = pos - points[static_cast<size_t>(p)];
+                double dsq = glm::dot(d, d);
+                if (dsq == 0.0) {
+                    force += jitter(index, other, jitterAmount);
+                    continue;
+                }
+                double rep = repulsiveConstant / dsq;
+                force += rep * (d / std::sqrt(dsq));
+            }
+            k = node.skip;
+        }
+        return force;
+    }
+
+    size_t node_count() const {
+        return nodes.size();
+    }
+
+    static Vec point(const std::array<std::vector<double>, kDims>& axes, size_t i) {
+        Vec p(0.0);
+        for (int d = 0; d < kDims; ++d) {
+            p[d] = axes[static_cast<size_t>(d)][i];
+        }
+        return p;
+    }
+
+private:
+    std::vector<Node> nodes;
+    std::vector<std::pair<uint64_t, int32_t>> order;
+    std::vector<Vec> points;
+    std::vector<int32_t> ids;
+
+    static uint32_t quantize(double value, double cells) {
+        if (!(value > 0.0)) return 0;
+        if (value >= cells) return static_cast<uint32_t>(cells) - 1;
+        return static_cast<uint32_t>(value);
+    }
+
+    // Spreads the low 21 bits of v so kDims - 1 zero bits separate each one.
+    static uint64_t spread(uint32_t v) {
+        uint64_t x = v & 0x1fffff;
+        if constexpr (kDims == 2) {
+            x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+            x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+            x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+            x = (x | (x << 2)) & 0x3333333333333333ULL;
+            x = (x | (x << 1)) & 0x5555555555555555ULL;
+            return x;
+        }
+        x = (x | (x << 32)) & 0x1f00000000ffffULL;
+        x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+        x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+        x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+        x = (x | (x << 2)) & 0x1249249249249249ULL;
+        return x;
+    }
+
+    // Deterministic push apart for coincident points; safe to call from
+    // parallel repulsion loops unlike rand().
+    static Vec jitter(int32_t a, int32_t b, double amount) {
+        uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b);
+        auto next = [&h]() {
+            h += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = h;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            z ^= z >> 31;
+            return static_cast<double>(z >> 11) / static_cast<double>(1ULL << 53) - 0.5;
+        };
+        Vec offset(0.0);
+        offset.x = next() * amount;
+        offset.y = next() * amount;
+        return offset;
+    }
+
+    // Builds the subtree for sorted points [begin, end) in pre-order and
+    // returns its mass-weighted position sum.
+    Vec buildNode(int32_t begin, int32_t end, int depth, double size) {
+        const size_t self = nodes.size();
+        nodes.emplace_back();
+        nodes[self].begin = begin;
+        nodes[self].end = end;
+        nodes[self].size = size;
+
+        Vec sum(0.0);
+        if (end - begin <= kLeafCapacity || depth == kMaxDepth) {
+            for (int32_t p = begin; p < end; ++p) {
+                sum += points[static_cast<size_t>(p)];
+            }
+        } else {
+            nodes[self].leaf = false;
+            constexpr uint64_t mask = (1u << kDims) - 1;
+            const int shift = kDims * (kMaxDepth - 1 - depth);
+            int32_t childBegin = begin;
+            while (childBegin < end) {
+                const uint64_t cell = (order[static_cast<size_t>(childBegin)].first >> shift) & mask;
+                auto last = std::partition_point(order.begin() + childBegin, order.begin() + end,
+                    [shift, cell](const std::pair<uint64_t, int32_t>& entry) {
+                        return ((entry.first >> shift) & mask) == cell;
+                    });
+                const int32_t childEnd = static_cast<int32_t>(last - order.begin());
+                sum += buildNode(childBegin, childEnd, depth + 1, size * 0.5);
+                childBegin = childEnd;
+            }
+        }
+
+        Node& node = nodes[self];
+        node.mass = static_cast<double>(end - begin);
+        node.massCenter = sum / node.mass;
+        node.skip = static_cast<int32_t>(nodes.size());
+        return sum;
+    }
+};
@@ -3,11 +3,13 @@
 #include <string>
 #include <vector>
 
+#include "job_system.h"
+
 struct GltfMeshBatch {
     std::vector<float> vertices;
     int image_index { 0 };
     std::string image_uri;
-    std::string image_bytes;
+    JobSystem::SharedBytes image_bytes;
 };
 
 struct GltfMeshJobResult {
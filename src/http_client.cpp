@@ -4,7 +4,10 @@
 #include <chrono>
 #include <cctype>
 #include <curl/curl.h>
+#include <deque>
+#include <map>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
 namespace {
@@ -67,16 +70,66 @@ CurlGlobalInit curl_global_init_guard;
 
 } // namespace
 
-HttpClient::HttpClient(std::size_t thread_count)
+struct HttpClient::Multi {
+    struct Transfer {
+        QueuedRequest req;
+        CURL* easy { nullptr };
+        curl_slist* header_list { nullptr };
+        std::string body;
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    CURLM* handle { nullptr };
+    CURLSH* share { nullptr };
+    std::multimap<std::chrono::steady_clock::time_point, QueuedRequest> delayed;
+    std::deque<QueuedRequest> ready;
+    std::unordered_map<uint64_t, std::unique_ptr<Transfer>> active;
+    std::vector<CURL*> idle;
+
+    // Detaches a transfer from the multi handle and keeps its easy handle for
+    // reuse; curl_easy_reset leaves the connection and session caches intact.
+    void release(Transfer& transfer, std::size_t max_idle)
+    {
+        curl_multi_remove_handle(handle, transfer.easy);
+        if (transfer.header_list) {
+            curl_slist_free_all(transfer.header_list);
+            transfer.header_list = nullptr;
+        }
+        if (idle.size() < max_idle) {
+            curl_easy_reset(transfer.easy);
+            idle.push_back(transfer.easy);
+        } else {
+            curl_easy_cleanup(transfer.easy);
+        }
+        transfer.easy = nullptr;
+    }
+};
+
+HttpClient::HttpClient(HttpClientOptions options_)
+    : options(options_)
+    , multi(std::make_unique<Multi>())
 {
-    if (thread_count == 0) {
-        thread_count = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    if (options.max_active_transfers == 0) {
+        options.max_active_transfers = 1;
     }
 
-    workers.reserve(thread_count);
-    for (std::size_t i = 0; i < thread_count; ++i) {
-        workers.emplace_back([this]() { worker_loop(); });
+    multi->handle = curl_multi_init();
+    if (!multi->handle) {
+        throw std::runtime_error("curl_multi_init failed");
+    }
+    curl_multi_setopt(multi->handle, CURLMOPT_PIPELINING, options.http2 ? CURLPIPE_MULTIPLEX : 0L);
+    curl_multi_setopt(multi->handle, CURLMOPT_MAX_HOST_CONNECTIONS, options.max_host_connections);
+    curl_multi_setopt(multi->handle, CURLMOPT_MAX_TOTAL_CONNECTIONS, options.max_total_connections);
+    curl_multi_setopt(multi->handle, CURLMOPT_MAXCONNECTS, options.max_total_connections);
+
+    // Only the loop thread touches the share, so it needs no lock callbacks.
+    multi->share = curl_share_init();
+    if (multi->share) {
+        curl_share_setopt(multi->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(multi->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
     }
+
+    loop_thread = std::thread([this]() { loop(); });
 }
 
 HttpClient::~HttpClient()
@@ -91,24 +144,30 @@ uint64_t HttpClient::submit(const HttpRequest& request)
     }
 
     uint64_t id = next_id.fetch_add(1);
-    auto cancel_flag = std::make_shared<std::atomic<bool>>(false);
     {
         std::lock_guard<std::mutex> lock(queue_mutex);
-        pending.push(QueuedRequest { id, request, cancel_flag });
-        cancel_flags[id] = cancel_flag;
+        if (stop.load()) {
+            return id;
+        }
+        incoming.push_back(QueuedRequest { id, request });
+        live_ids.insert(id);
+        // Woken under the lock so shutdown() cannot free the multi handle
+        // in between.
+        curl_multi_wakeup(multi->handle);
     }
-    queue_cv.notify_one();
     return id;
 }
 
 bool HttpClient::cancel(uint64_t id)
 {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    auto it = cancel_flags.find(id);
-    if (it == cancel_flags.end()) {
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stop.load() || live_ids.find(id) == live_ids.end()) {
+            return false;
+        }
+        cancel_requests.push_back(id);
+        curl_multi_wakeup(multi->handle);
     }
-    it->second->store(true);
     return true;
 }
 
@@ -129,150 +188,267 @@ std::vector<HttpResponse> HttpClient::poll(std::size_t max_results)
 
 void HttpClient::shutdown()
 {
-    bool expected = false;
-    if (!stop.compare_exchange_strong(expected, true)) {
-        return;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stop.load()) {
+            return;
+        }
+        stop.store(true);
     }
 
-    queue_cv.notify_all();
-    for (auto& worker : workers) {
-        if (worker.joinable()) {
-            worker.join();
-        }
+    curl_multi_wakeup(multi->handle);
+    if (loop_thread.joinable()) {
+        loop_thread.join();
     }
 
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        std::queue<QueuedRequest> empty;
-        pending.swap(empty);
-        cancel_flags.clear();
+    for (auto& entry : multi->active) {
+        multi->release(*entry.second, 0);
+    }
+    multi->active.clear();
+    multi->ready.clear();
+    multi->delayed.clear();
+    for (CURL* easy : multi->idle) {
+        curl_easy_cleanup(easy);
+    }
+    multi->idle.clear();
+    curl_multi_cleanup(multi->handle);
+    multi->handle = nullptr;
+    if (multi->share) {
+        curl_share_cleanup(multi->share);
+        multi->share = nullptr;
     }
+
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    incoming.clear();
+    cancel_requests.clear();
+    live_ids.clear();
 }
 
-bool HttpClient::pop_request(QueuedRequest& out)
+void HttpClient::loop()
 {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-    queue_cv.wait(lock, [this]() { return stop.load() || !pending.empty(); });
-    if (stop.load()) {
-        return false;
+    while (!stop.load()) {
+        take_incoming();
+        start_ready();
+
+        int running = 0;
+        curl_multi_perform(multi->handle, &running);
+        drain_finished();
+
+        curl_multi_poll(multi->handle, nullptr, 0, wait_timeout_ms(), nullptr);
     }
-    out = std::move(pending.front());
-    pending.pop();
-    return true;
 }
 
-void HttpClient::worker_loop()
+void HttpClient::take_incoming()
 {
-    while (!stop.load()) {
-        QueuedRequest req;
-        if (!pop_request(req)) {
-            break;
-        }
+    std::vector<QueuedRequest> requests;
+    std::vector<uint64_t> cancels;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        requests.swap(incoming);
+        cancels.swap(cancel_requests);
+    }
 
-        if (req.cancel_flag && req.cancel_flag->load()) {
-            HttpResponse cancelled = make_cancelled_response(req);
-            std::lock_guard<std::mutex> lock(completed_mutex);
-            completed.push_back(std::move(cancelled));
-            continue;
+    auto now = std::chrono::steady_clock::now();
+    for (auto& req : requests) {
+        if (req.request.delay_ms > 0) {
+            auto due = now + std::chrono::milliseconds(req.request.delay_ms);
+            multi->delayed.emplace(due, std::move(req));
+        } else {
+            multi->ready.push_back(std::move(req));
         }
+    }
+    for (uint64_t id : cancels) {
+        cancel_queued(id);
+    }
+}
 
-        HttpResponse resp = perform(req);
-        {
-            std::lock_guard<std::mutex> lock(completed_mutex);
-            completed.push_back(std::move(resp));
-        }
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            cancel_flags.erase(req.id);
+void HttpClient::cancel_queued(uint64_t id)
+{
+    auto running = multi->active.find(id);
+    if (running != multi->active.end()) {
+        multi->release(*running->second, options.max_active_transfers);
+        multi->active.erase(running);
+        complete(make_cancelled_response(id));
+        return;
+    }
+    auto ready = std::find_if(multi->ready.begin(), multi->ready.end(),
+        [id](const QueuedRequest& req) { return req.id == id; });
+    if (ready != multi->ready.end()) {
+        multi->ready.erase(ready);
+        complete(make_cancelled_response(id));
+        return;
+    }
+    for (auto it = multi->delayed.begin(); it != multi->delayed.end(); ++it) {
+        if (it->second.id == id) {
+            multi->delayed.erase(it);
+            complete(make_cancelled_response(id));
+            return;
         }
     }
 }
 
-HttpResponse HttpClient::make_cancelled_response(const QueuedRequest& req)
+void HttpClient::start_ready()
 {
-    HttpResponse resp;
-    resp.id = req.id;
-    resp.cancelled = true;
-    resp.ok = false;
-    resp.status = 0;
-    resp.error = "cancelled";
-    return resp;
+    auto now = std::chrono::steady_clock::now();
+    while (!multi->delayed.empty() && multi->delayed.begin()->first <= now) {
+        multi->ready.push_back(std::move(multi->delayed.begin()->second));
+        multi->delayed.erase(multi->delayed.begin());
+    }
+    while (!multi->ready.empty() && multi->active.size() < options.max_active_transfers) {
+        QueuedRequest req = std::move(multi->ready.front());
+        multi->ready.pop_front();
+        start_transfer(std::move(req));
+    }
+}
+
+int HttpClient::wait_timeout_ms() const
+{
+    if (!multi->ready.empty() && multi->active.size() < options.max_active_transfers) {
+        return 0;
+    }
+    long timeout = -1;
+    curl_multi_timeout(multi->handle, &timeout);
+    if (timeout < 0) {
+        // Nothing pending inside curl; submit() and cancel() wake the poll.
+        timeout = 1000;
+    }
+    if (!multi->delayed.empty()) {
+        auto until = std::chrono::duration_cast<std::chrono::milliseconds>(
+            multi->delayed.begin()->first - std::chrono::steady_clock::now()).count();
+        timeout = std::min<long>(timeout, std::max<long>(0, static_cast<long>(until)));
+    }
+    return static_cast<int>(timeout);
 }
 
-HttpResponse HttpClient::perform(const QueuedRequest& req)
+void HttpClient::start_transfer(QueuedRequest req)
 {
-    HttpResponse out;
-    out.id = req.id;
-    CURL* curl = curl_easy_init();
+    auto transfer = std::make_unique<Multi::Transfer>();
+    transfer->req = std::move(req);
+    const HttpRequest& request = transfer->req.request;
+    const uint64_t id = transfer->req.id;
+
+    CURL* curl = nullptr;
+    if (!multi->idle.empty()) {
+        curl = multi->idle.back();
+        multi->idle.pop_back();
+    } else {
+        curl = curl_easy_init();
+    }
     if (!curl) {
+        HttpResponse out;
+        out.id = id;
         out.error = "curl_easy_init failed";
-        return out;
+        complete(std::move(out));
+        return;
     }
+    transfer->easy = curl;
 
-    std::string body;
-    std::vector<std::pair<std::string, std::string>> headers_out;
-
-    curl_easy_setopt(curl, CURLOPT_URL, req.request.url.c_str());
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, req.request.follow_redirects ? 1L : 0L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, req.request.user_agent.c_str());
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, request.follow_redirects ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, request.user_agent.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_body);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->body);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, write_header);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers_out);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->headers);
     curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+    if (multi->share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, multi->share);
+    }
+    if (options.http2) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+        // Wait for an existing connection that can multiplex rather than
+        // opening a new one per request.
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
 
-    if (!req.request.body.empty()) {
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.request.body.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, req.request.body.size());
+    if (!request.body.empty()) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.size()));
     }
 
-    if (!req.request.method.empty()) {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, req.request.method.c_str());
+    if (!request.method.empty()) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
     }
 
-    curl_slist* header_list = build_header_list(req.request.headers);
-    if (header_list) {
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+    transfer->header_list = build_header_list(request.headers);
+    if (transfer->header_list) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->header_list);
     }
 
-    if (req.request.timeout_ms > 0) {
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, req.request.timeout_ms);
+    if (request.timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, request.timeout_ms);
     }
-    if (req.request.connect_timeout_ms > 0) {
-        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, req.request.connect_timeout_ms);
+    if (request.connect_timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, request.connect_timeout_ms);
     }
 
-    std::shared_ptr<std::atomic<bool>> cancel_flag = req.cancel_flag;
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION,
-        +[](void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) -> int {
-            auto* flag = static_cast<std::atomic<bool>*>(clientp);
-            return (flag && flag->load()) ? 1 : 0;
-        });
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel_flag.get());
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    if (req.request.delay_ms > 0) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(req.request.delay_ms));
+    CURLMcode code = curl_multi_add_handle(multi->handle, curl);
+    if (code != CURLM_OK) {
+        HttpResponse out;
+        out.id = id;
+        out.error = curl_multi_strerror(code);
+        if (transfer->header_list) {
+            curl_slist_free_all(transfer->header_list);
+        }
+        curl_easy_cleanup(curl);
+        complete(std::move(out));
+        return;
     }
+    multi->active.emplace(id, std::move(transfer));
+}
 
-    CURLcode code = curl_easy_perform(curl);
-    if (cancel_flag && cancel_flag->load()) {
-        out = make_cancelled_response(req);
-    } else if (code != CURLE_OK) {
-        out.ok = false;
-        out.error = curl_easy_strerror(code);
-    } else {
-        long status = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
-        out.ok = (status >= 200 && status < 400);
-        out.status = status;
-        out.body = std::move(body);
-        out.headers = std::move(headers_out);
+void HttpClient::drain_finished()
+{
+    int remaining = 0;
+    while (CURLMsg* msg = curl_multi_info_read(multi->handle, &remaining)) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        char* data = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &data);
+        auto* transfer = reinterpret_cast<Multi::Transfer*>(data);
+        const CURLcode code = msg->data.result;
+
+        HttpResponse out;
+        out.id = transfer->req.id;
+        if (code != CURLE_OK) {
+            out.ok = false;
+            out.error = curl_easy_strerror(code);
+        } else {
+            long status = 0;
+            curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status);
+            out.ok = (status >= 200 && status < 400);
+            out.status = status;
+            out.body = std::move(transfer->body);
+            out.headers = std::move(transfer->headers);
+        }
+
+        multi->release(*transfer, options.max_active_transfers);
+        multi->active.erase(out.id);
+        complete(std::move(out));
     }
+}
 
-    if (header_list) {
-        curl_slist_free_all(header_list);
+void HttpClient::complete(HttpResponse response)
+{
+    const uint64_t id = response.id;
+    {
+        std::lock_guard<std::mutex> lock(completed_mutex);
+        completed.push_back(std::move(response));
     }
-    curl_easy_cleanup(curl);
-    return out;
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    live_ids.erase(id);
+}
+
+HttpResponse HttpClient::make_cancelled_response(uint64_t id)
+{
+    HttpResponse resp;
+    resp.id = id;
+    resp.cancelled = true;
+    resp.ok = false;
+    resp.status = 0;
+    resp.error = "cancelled";
+    return resp;
 }
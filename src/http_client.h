@@ -1,15 +1,13 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
-#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -35,9 +33,23 @@ struct HttpResponse {
     std::vector<std::pair<std::string, std::string>> headers;
 };
 
+struct HttpClientOptions {
+    // Connections libcurl may open to one host; HTTP/2 requests to that host
+    // are multiplexed over them as streams.
+    long max_host_connections { 6 };
+    long max_total_connections { 64 };
+    // Transfers handed to curl at once; the rest wait in submission order.
+    std::size_t max_active_transfers { 256 };
+    bool http2 { true };
+};
+
+// Runs every request on one curl_multi loop thread. Easy handles, the
+// connection cache and the DNS/TLS session caches are reused across
+// requests, so bursts to the same host share handshakes. Delayed requests
+// wait on the loop's timer instead of occupying a thread.
 class HttpClient {
 public:
-    explicit HttpClient(std::size_t thread_count = 0);
+    explicit HttpClient(HttpClientOptions options = {});
     ~HttpClient();
 
     HttpClient(const HttpClient&) = delete;
@@ -52,24 +64,31 @@ private:
     struct QueuedRequest {
         uint64_t id { 0 };
         HttpRequest request;
-        std::shared_ptr<std::atomic<bool>> cancel_flag;
     };
+    struct Multi;
 
-    void worker_loop();
-    HttpResponse perform(const QueuedRequest& req);
-    HttpResponse make_cancelled_response(const QueuedRequest& req);
-    bool pop_request(QueuedRequest& out);
+    void loop();
+    void take_incoming();
+    void start_ready();
+    void start_transfer(QueuedRequest req);
+    void drain_finished();
+    void cancel_queued(uint64_t id);
+    int wait_timeout_ms() const;
+    void complete(HttpResponse response);
+    static HttpResponse make_cancelled_response(uint64_t id);
 
+    HttpClientOptions options;
     std::atomic<bool> stop { false };
     std::atomic<uint64_t> next_id { 1 };
 
     std::mutex queue_mutex;
-    std::condition_variable queue_cv;
-    std::queue<QueuedRequest> pending;
-    std::unordered_map<uint64_t, std::shared_ptr<std::atomic<bool>>> cancel_flags;
+    std::vector<QueuedRequest> incoming;
+    std::vector<uint64_t> cancel_requests;
+    std::unordered_set<uint64_t> live_ids; // submitted and not yet completed
 
     std::mutex completed_mutex;
     std::vector<HttpResponse> completed;
 
-    std::vector<std::thread> workers;
+    std::unique_ptr<Multi> multi; // curl state, owned by the loop thread
+    std::thread loop_thread;
 };
@@ -20,13 +20,44 @@ std::size_t resolve_thread_count(std::size_t requested) {
     return std::max<std::size_t>(1, hardware - 1);
 }
 
+constexpr std::size_t kNoWorker = static_cast<std::size_t>(-1);
+
+thread_local const JobSystem* tls_owner = nullptr;
+thread_local std::size_t tls_worker_index = kNoWorker;
+thread_local uint64_t tls_current_job = 0;
+
+std::size_t priority_index(JobSystem::JobPriority priority) {
+    auto index = static_cast<std::size_t>(priority);
+    return index < JobSystem::kPriorityCount ? index : static_cast<std::size_t>(JobSystem::JobPriority::Normal);
+}
+
+std::size_t owner_index(JobSystem::JobOwner owner) {
+    return owner == JobSystem::JobOwner::Lua ? 1 : 0;
+}
+
+// Adds a reference unless the count already dropped to zero, so a finished
+// parent can never be revived by a late child.
+bool retain_pending(std::atomic<uint32_t>& pending) {
+    uint32_t current = pending.load();
+    while (current > 0) {
+        if (pending.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace
 
 JobSystem::JobSystem(std::size_t threadCount) {
     std::size_t workersCount = resolve_thread_count(threadCount);
+    queues.reserve(workersCount);
+    for (std::size_t i = 0; i < workersCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
     workers.reserve(workersCount);
     for (std::size_t i = 0; i < workersCount; ++i) {
-        workers.emplace_back([this]() { worker_loop(); });
+        workers.emplace_back([this, i]() { worker_loop(i); });
     }
 }
 
@@ -40,7 +71,10 @@ void JobSystem::shutdown() {
         return;
     }
 
-    queueCv.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCv.notify_all();
+    }
     for (auto& worker : workers) {
         if (worker.joinable()) {
             worker.join();
@@ -48,194 +82,521 @@ void JobSystem::shutdown() {
     }
 }
 
+std::size_t JobSystem::worker_count() const {
+    return workers.size();
+}
+
+uint64_t JobSystem::current_job() {
+    return tls_current_job;
+}
+
 void JobSystem::register_handler(const std::string& kind, JobHandler handler) {
     if (!handler) {
         throw std::invalid_argument("Job handler must not be empty");
     }
-    std::lock_guard<std::mutex> lock(handlerMutex);
-    handlers[kind] = handler;
+    auto shared = std::make_shared<const JobHandler>(std::move(handler));
+    KindEntry& entry = intern_kind(kind);
+    std::unique_lock<std::shared_mutex> lock(handlerMutex);
+    entry.handler = std::move(shared);
+}
+
+JobSystem::KindEntry* JobSystem::find_kind(const std::string& kind) {
+    std::shared_lock<std::shared_mutex> lock(handlerMutex);
+    auto it = kindIds.find(kind);
+    if (it == kindIds.end()) {
+        return nullptr;
+    }
+    return &kinds[it->second];
 }
 
-uint64_t JobSystem::submit(const std::string& kind, const std::string& payload, JobOwner owner) {
+JobSystem::KindEntry& JobSystem::intern_kind(const std::string& kind) {
+    if (KindEntry* existing = find_kind(kind)) {
+        return *existing;
+    }
+    std::unique_lock<std::shared_mutex> lock(handlerMutex);
+    auto it = kindIds.find(kind);
+    if (it != kindIds.end()) {
+        return kinds[it->second];
+    }
+    KindId id = static_cast<KindId>(kinds.size());
+    KindEntry& entry = kinds.emplace_back();
+    entry.id = id;
+    entry.name = kind;
+    kindIds.emplace(kind, id);
+    return entry;
+}
+
+JobSystem::KindId JobSystem::kind_id(const std::string& kind) {
+    return intern_kind(kind).id;
+}
+
+uint64_t JobSystem::submit(const std::string& kind, std::string payload, JobOwner owner) {
+    return submit(kind, std::move(payload), owner, SubmitOptions {});
+}
+
+uint64_t JobSystem::submit(const std::string& kind,
+                           std::string payload,
+                           JobOwner owner,
+                           const SubmitOptions& options) {
     uint64_t id = nextId.fetch_add(1);
+    auto submittedAt = std::chrono::steady_clock::now();
 
+    // The handler is resolved once here so workers never touch handlerMutex.
+    KindEntry& entry = intern_kind(kind);
+    std::shared_ptr<const JobHandler> handler;
     {
-        std::lock_guard<std::mutex> handlerLock(handlerMutex);
-        if (handlers.find(kind) == handlers.end()) {
-            JobResult immediate { id, false, kind, std::string(), "Unknown job kind: " + kind,
-                                   {}, 0, 0, 0, 0, owner };
-            std::lock_guard<std::mutex> completedLock(completedMutex);
-            completed.push_back(std::move(immediate));
+        std::shared_lock<std::shared_mutex> lock(handlerMutex);
+        handler = entry.handler;
+    }
+    entry.submitted.fetch_add(1, std::memory_order_relaxed);
+    if (!handler) {
+        entry.started.fetch_add(1, std::memory_order_relaxed);
+        publish(entry,
+                JobResult { id, false, kind, std::string(), "Unknown job kind: " + kind,
+                            {}, 0, 0, 0, 0, owner },
+                submittedAt);
+        return id;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->request = JobRequest { id, kind, std::move(payload), owner, options.priority, options.parent,
+                                options.bytes, options.aux_a, options.aux_b, options.aux_c, options.aux_d };
+    job->kind = &entry;
+    job->submittedAt = submittedAt;
+    job->handler = std::move(handler);
+    job->tag = options.tag;
+    if (options.timeout.count() > 0) {
+        job->deadline = submittedAt + options.timeout;
+        job->hasDeadline = true;
+    }
+
+    if (options.parent != 0) {
+        JobPtr parent = find_live(options.parent);
+        if (!parent || !retain_pending(parent->pending)) {
+            entry.started.fetch_add(1, std::memory_order_relaxed);
+            publish(entry,
+                    JobResult { id, false, kind, std::string(),
+                                "Unknown or finished parent job: " + std::to_string(options.parent),
+                                {}, 0, 0, 0, 0, owner },
+                    submittedAt);
             return id;
         }
+        job->parent = std::move(parent);
     }
 
+    track_live(job);
+    enqueue(std::move(job));
+    return id;
+}
+
+void JobSystem::enqueue(JobPtr job) {
+    // Jobs submitted from a worker (typically child jobs) stay on that worker's
+    // deque; everything else is spread round-robin.
+    std::size_t target = (tls_owner == this && tls_worker_index < queues.size())
+        ? tls_worker_index
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    std::size_t priority = priority_index(job->request.priority);
+
+    WorkerQueue& queue = *queues[target];
     {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        jobQueue.push(JobRequest { id, kind, payload, owner });
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.deques[priority].push_back(std::move(job));
+        queue.sizes[priority].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    queuedCount.fetch_add(1);
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCv.notify_one();
     }
-    queueCv.notify_one();
-    return id;
 }
 
-std::vector<JobSystem::JobResult> JobSystem::poll(std::size_t maxResults) {
-    std::vector<JobResult> results;
-    std::lock_guard<std::mutex> lock(completedMutex);
+JobSystem::JobPtr JobSystem::pop_local(std::size_t index, std::size_t priority) {
+    WorkerQueue& queue = *queues[index];
+    if (queue.sizes[priority].load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    auto& deque = queue.deques[priority];
+    if (deque.empty()) {
+        return nullptr;
+    }
+    JobPtr job = std::move(deque.front());
+    deque.pop_front();
+    queue.sizes[priority].fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
 
-    if (completed.empty()) {
-        return results;
+JobSystem::JobPtr JobSystem::steal(std::size_t victim, std::size_t priority) {
+    WorkerQueue& queue = *queues[victim];
+    if (queue.sizes[priority].load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return nullptr;
+    }
+    auto& deque = queue.deques[priority];
+    if (deque.empty()) {
+        return nullptr;
     }
+    JobPtr job = std::move(deque.back());
+    deque.pop_back();
+    queue.sizes[priority].fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
 
-    if (maxResults == 0 || maxResults >= completed.size()) {
-        results.swap(completed);
-        return results;
+JobSystem::JobPtr JobSystem::take_job(std::size_t index) {
+    const std::size_t count = queues.size();
+    for (std::size_t priority = 0; priority < kPriorityCount; ++priority) {
+        JobPtr job = pop_local(index, priority);
+        for (std::size_t offset = 1; !job && offset < count; ++offset) {
+            job = steal((index + offset) % count, priority);
+        }
+        if (job) {
+            queuedCount.fetch_sub(1);
+            return job;
+        }
     }
+    return nullptr;
+}
 
-    results.reserve(maxResults);
-    auto begin = completed.begin();
-    auto split = begin + static_cast<std::ptrdiff_t>(maxResults);
-    results.insert(results.end(),
-                   std::make_move_iterator(begin),
-                   std::make_move_iterator(split));
-    completed.erase(begin, split);
-    return results;
+void JobSystem::worker_loop(std::size_t index) {
+    tls_owner = this;
+    tls_worker_index = index;
+
+    while (true) {
+        JobPtr job = take_job(index);
+        if (job) {
+            run_job(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        sleepCv.wait(lock, [this]() { return stop.load() || queuedCount.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+        if (stop.load() && queuedCount.load() == 0) {
+            break;
+        }
+    }
+
+    tls_owner = nullptr;
+    tls_worker_index = kNoWorker;
 }
 
-std::vector<JobSystem::JobResult> JobSystem::poll_kind(const std::string& kind, std::size_t maxResults) {
-    std::vector<JobResult> results;
-    std::lock_guard<std::mutex> lock(completedMutex);
-    if (completed.empty()) {
-        return results;
+void JobSystem::run_job(const JobPtr& job) {
+    const JobRequest& request = job->request;
+
+    if (job->hasDeadline && std::chrono::steady_clock::now() > job->deadline) {
+        cancel_job(job, "Job deadline exceeded");
+        return;
+    }
+    int expected = Queued;
+    if (!job->state.compare_exchange_strong(expected, Running)) {
+        // Cancelled while queued; its result was already published.
+        return;
     }
 
-    auto matches_kind = [&kind](const JobResult& res) { return res.kind == kind; };
+    JobResult result {};
+    result.id = request.id;
+    result.kind = request.kind;
+    result.ok = false;
 
-    if (maxResults == 0) {
-        maxResults = completed.size();
+    job->kind->started.fetch_add(1, std::memory_order_relaxed);
+    tls_current_job = request.id;
+    try {
+        result = (*job->handler)(request);
+        result.id = request.id;
+    } catch (const std::exception& ex) {
+        result.ok = false;
+        result.error = ex.what();
+    } catch (...) {
+        result.ok = false;
+        result.error = "Unhandled exception in job handler";
     }
+    tls_current_job = 0;
+    result.owner = request.owner;
 
-    auto it = completed.begin();
-    while (it != completed.end() && results.size() < maxResults) {
-        if (matches_kind(*it)) {
-            results.push_back(std::move(*it));
-            it = completed.erase(it);
-        } else {
-            ++it;
-        }
+    job->result = std::move(result);
+    finish_job(job);
+}
+
+bool JobSystem::cancel_job(const JobPtr& job, const char* reason) {
+    int expected = Queued;
+    if (!job->state.compare_exchange_strong(expected, Cancelled)) {
+        return false;
     }
+    // The stale deque entry is skipped when a worker pops it.
+    job->kind->started.fetch_add(1, std::memory_order_relaxed);
+    job->kind->cancelled.fetch_add(1, std::memory_order_relaxed);
+
+    JobResult result {};
+    result.id = job->request.id;
+    result.kind = job->request.kind;
+    result.ok = false;
+    result.error = reason;
+    result.owner = job->request.owner;
+    result.cancelled = true;
+    job->result = std::move(result);
+    finish_job(job);
+    return true;
+}
 
-    return results;
+bool JobSystem::cancel(uint64_t id) {
+    JobPtr job = find_live(id);
+    return job && cancel_job(job, "Job cancelled");
 }
 
-std::vector<JobSystem::JobResult> JobSystem::poll_owner(JobOwner owner, std::size_t maxResults) {
-    std::vector<JobResult> results;
-    std::lock_guard<std::mutex> lock(completedMutex);
-    if (completed.empty()) {
-        return results;
+template <typename Predicate>
+std::size_t JobSystem::cancel_matching(Predicate predicate) {
+    std::vector<JobPtr> matches;
+    for (auto& shard : liveShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& entry : shard.jobs) {
+            if (entry.second->state.load() == Queued && predicate(*entry.second)) {
+                matches.push_back(entry.second);
+            }
+        }
+    }
+    // Cancelling publishes and untracks, which takes the shard locks again.
+    std::size_t cancelled = 0;
+    for (const auto& job : matches) {
+        if (cancel_job(job, "Job cancelled")) {
+            cancelled++;
+        }
     }
+    return cancelled;
+}
 
-    auto matches_owner = [owner](const JobResult& res) { return res.owner == owner; };
+std::size_t JobSystem::cancel_tag(const std::string& tag) {
+    if (tag.empty()) {
+        return 0;
+    }
+    return cancel_matching([&tag](const Job& job) { return job.tag == tag; });
+}
+
+std::size_t JobSystem::cancel_owner(JobOwner owner) {
+    return cancel_matching([owner](const Job& job) { return job.request.owner == owner; });
+}
+
+void JobSystem::finish_job(JobPtr job) {
+    // Completing a child may release its parent, which may release its own
+    // parent in turn.
+    while (job) {
+        if (job->pending.fetch_sub(1) != 1) {
+            return;
+        }
+        untrack_live(job->request.id);
+        publish(*job->kind, std::move(job->result), job->submittedAt);
+        JobPtr parent = std::move(job->parent);
+        job = std::move(parent);
+    }
+}
 
-    if (maxResults == 0) {
-        maxResults = completed.size();
+void JobSystem::publish(KindEntry& kind,
+                        JobResult&& result,
+                        std::chrono::steady_clock::time_point submittedAt) {
+    auto elapsed = std::chrono::steady_clock::now() - submittedAt;
+    auto latencyUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    kind.totalLatencyUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    uint64_t previousMax = kind.maxLatencyUs.load(std::memory_order_relaxed);
+    while (latencyUs > previousMax &&
+           !kind.maxLatencyUs.compare_exchange_weak(previousMax, latencyUs, std::memory_order_relaxed)) {
+    }
+    if (!result.ok && !result.cancelled) {
+        kind.failed.fetch_add(1, std::memory_order_relaxed);
     }
 
-    auto it = completed.begin();
-    while (it != completed.end() && results.size() < maxResults) {
-        if (matches_owner(*it)) {
-            results.push_back(std::move(*it));
-            it = completed.erase(it);
-        } else {
-            ++it;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        if (kind.id >= completed.size()) {
+            completed.resize(static_cast<std::size_t>(kind.id) + 1);
         }
+        completed[kind.id][owner_index(result.owner)].push_back(
+            CompletedEntry { completedSequence++, std::move(result) });
+        completedCount++;
     }
+    kind.completed.fetch_add(1, std::memory_order_relaxed);
+}
 
-    return results;
+JobSystem::LiveShard& JobSystem::live_shard(uint64_t id) {
+    return liveShards[id % kLiveShardCount];
 }
 
-std::vector<JobSystem::JobResult> JobSystem::poll_kind_owner(const std::string& kind,
-                                                             JobOwner owner,
-                                                             std::size_t maxResults) {
+void JobSystem::track_live(const JobPtr& job) {
+    LiveShard& shard = live_shard(job->request.id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.jobs.emplace(job->request.id, job);
+}
+
+void JobSystem::untrack_live(uint64_t id) {
+    LiveShard& shard = live_shard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.jobs.erase(id);
+}
+
+JobSystem::JobPtr JobSystem::find_live(uint64_t id) {
+    LiveShard& shard = live_shard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.jobs.find(id);
+    if (it == shard.jobs.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+std::vector<JobSystem::JobResult> JobSystem::drain_merged(std::vector<CompletedQueue*>& sources,
+                                                          std::size_t maxResults) {
     std::vector<JobResult> results;
-    std::lock_guard<std::mutex> lock(completedMutex);
-    if (completed.empty()) {
+    sources.erase(std::remove_if(sources.begin(), sources.end(),
+                                 [](CompletedQueue* queue) { return queue->empty(); }),
+                  sources.end());
+    if (sources.empty()) {
         return results;
     }
 
-    auto matches = [&kind, owner](const JobResult& res) { return res.kind == kind && res.owner == owner; };
-
-    if (maxResults == 0) {
-        maxResults = completed.size();
+    std::size_t available = 0;
+    for (CompletedQueue* queue : sources) {
+        available += queue->size();
+    }
+    std::size_t take = (maxResults == 0) ? available : std::min(maxResults, available);
+    results.reserve(take);
+
+    // Each queue is already in sequence order, so repeatedly taking the smallest
+    // head yields global completion order. The number of non-empty queues is
+    // bounded by the number of job kinds.
+    while (results.size() < take) {
+        CompletedQueue* best = nullptr;
+        for (CompletedQueue* queue : sources) {
+            if (!queue->empty() && (!best || queue->front().sequence < best->front().sequence)) {
+                best = queue;
+            }
+        }
+        results.push_back(std::move(best->front().result));
+        best->pop_front();
     }
+    completedCount -= results.size();
+    return results;
+}
 
-    auto it = completed.begin();
-    while (it != completed.end() && results.size() < maxResults) {
-        if (matches(*it)) {
-            results.push_back(std::move(*it));
-            it = completed.erase(it);
-        } else {
-            ++it;
+std::vector<JobSystem::JobResult> JobSystem::poll(std::size_t maxResults) {
+    std::lock_guard<std::mutex> lock(completedMutex);
+    if (completedCount == 0) {
+        return {};
+    }
+    std::vector<CompletedQueue*> sources;
+    for (auto& owners : completed) {
+        for (auto& queue : owners) {
+            sources.push_back(&queue);
         }
     }
+    return drain_merged(sources, maxResults);
+}
 
-    return results;
+std::vector<JobSystem::JobResult> JobSystem::poll_kind(const std::string& kind, std::size_t maxResults) {
+    KindEntry* entry = find_kind(kind);
+    if (!entry) {
+        return {};
+    }
+    return poll_kind(entry->id, maxResults);
 }
 
-bool JobSystem::pop_job(JobRequest& out) {
-    std::unique_lock<std::mutex> lock(queueMutex);
-    queueCv.wait(lock, [this]() { return stop.load() || !jobQueue.empty(); });
+std::vector<JobSystem::JobResult> JobSystem::poll_kind(KindId kind, std::size_t maxResults) {
+    std::lock_guard<std::mutex> lock(completedMutex);
+    if (completedCount == 0 || kind >= completed.size()) {
+        return {};
+    }
+    std::vector<CompletedQueue*> sources;
+    for (auto& queue : completed[kind]) {
+        sources.push_back(&queue);
+    }
+    return drain_merged(sources, maxResults);
+}
 
-    if (stop.load() && jobQueue.empty()) {
-        return false;
+std::vector<JobSystem::JobResult> JobSystem::poll_owner(JobOwner owner, std::size_t maxResults) {
+    std::lock_guard<std::mutex> lock(completedMutex);
+    if (completedCount == 0) {
+        return {};
+    }
+    std::vector<CompletedQueue*> sources;
+    for (auto& owners : completed) {
+        sources.push_back(&owners[owner_index(owner)]);
     }
+    return drain_merged(sources, maxResults);
+}
 
-    out = std::move(jobQueue.front());
-    jobQueue.pop();
-    return true;
+std::vector<JobSystem::JobResult> JobSystem::poll_kind_owner(const std::string& kind,
+                                                             JobOwner owner,
+                                                             std::size_t maxResults) {
+    KindEntry* entry = find_kind(kind);
+    if (!entry) {
+        return {};
+    }
+    return poll_kind_owner(entry->id, owner, maxResults);
 }
 
-void JobSystem::worker_loop() {
-    while (!stop.load()) {
-        JobRequest request;
-        if (!pop_job(request)) {
-            break;
-        }
+std::vector<JobSystem::JobResult> JobSystem::poll_kind_owner(KindId kind,
+                                                             JobOwner owner,
+                                                             std::size_t maxResults) {
+    std::vector<JobResult> results;
+    std::lock_guard<std::mutex> lock(completedMutex);
+    if (kind >= completed.size()) {
+        return results;
+    }
+    CompletedQueue& queue = completed[kind][owner_index(owner)];
+    if (queue.empty()) {
+        return results;
+    }
 
-        JobResult result {};
-        result.id = request.id;
-        result.kind = request.kind;
-        result.ok = false;
+    std::size_t take = (maxResults == 0) ? queue.size() : std::min(maxResults, queue.size());
+    results.reserve(take);
+    for (std::size_t i = 0; i < take; ++i) {
+        results.push_back(std::move(queue.front().result));
+        queue.pop_front();
+    }
+    completedCount -= take;
+    return results;
+}
 
-        JobHandler handler;
-        {
-            std::lock_guard<std::mutex> lock(handlerMutex);
-            auto it = handlers.find(request.kind);
-            if (it != handlers.end()) {
-                handler = it->second;
-            }
+std::vector<JobSystem::KindStats> JobSystem::stats() {
+    std::vector<KindEntry*> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(handlerMutex);
+        entries.reserve(kinds.size());
+        for (auto& entry : kinds) {
+            entries.push_back(&entry);
         }
+    }
 
-        if (!handler) {
-            result.error = "Unknown job kind: " + request.kind;
-        } else {
-            try {
-                result = handler(request);
-                result.id = request.id;
-            } catch (const std::exception& ex) {
-                result.ok = false;
-                result.error = ex.what();
-            } catch (...) {
-                result.ok = false;
-                result.error = "Unhandled exception in job handler";
-            }
+    std::vector<KindStats> out;
+    out.reserve(entries.size());
+    for (KindEntry* entry : entries) {
+        KindStats stat;
+        stat.kind = entry->name;
+        stat.submitted = entry->submitted.load(std::memory_order_relaxed);
+        uint64_t started = entry->started.load(std::memory_order_relaxed);
+        stat.completed = entry->completed.load(std::memory_order_relaxed);
+        stat.failed = entry->failed.load(std::memory_order_relaxed);
+        stat.cancelled = entry->cancelled.load(std::memory_order_relaxed);
+        stat.queued = stat.submitted > started ? stat.submitted - started : 0;
+        stat.running = started > stat.completed ? started - stat.completed : 0;
+        if (stat.completed > 0) {
+            stat.avg_latency_ms = static_cast<double>(entry->totalLatencyUs.load(std::memory_order_relaxed)) /
+                                  static_cast<double>(stat.completed) / 1000.0;
         }
-        result.owner = request.owner;
+        stat.max_latency_ms = static_cast<double>(entry->maxLatencyUs.load(std::memory_order_relaxed)) / 1000.0;
+        out.push_back(std::move(stat));
+    }
 
-        {
-            std::lock_guard<std::mutex> lock(completedMutex);
-            completed.push_back(std::move(result));
+    std::lock_guard<std::mutex> lock(completedMutex);
+    for (std::size_t id = 0; id < out.size() && id < completed.size(); ++id) {
+        for (auto& queue : completed[id]) {
+            out[id].ready += queue.size();
         }
     }
+    return out;
 }
 
 void register_default_job_handlers(JobSystem& jobs) {
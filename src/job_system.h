@@ -1,13 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -20,11 +24,83 @@ public:
         Lua
     };
 
+    // Priority classes are drained strictly in order: a worker only runs a
+    // background job once no interactive or normal job is queued anywhere.
+    enum class JobPriority {
+        Interactive = 0,
+        Normal = 1,
+        Background = 2
+    };
+    static constexpr std::size_t kPriorityCount = 3;
+
+    // Immutable, refcounted bytes. Copies share one allocation, so large inputs
+    // reach workers (and child jobs) without being duplicated. view() aliases a
+    // region of any shared owner, e.g. a parsed glTF buffer.
+    struct SharedBytes {
+        std::shared_ptr<const std::uint8_t> data;
+        std::size_t size { 0 };
+
+        bool empty() const { return !data || size == 0; }
+        const std::uint8_t* get() const { return data.get(); }
+
+        template <typename Owner>
+        static SharedBytes view(std::shared_ptr<Owner> owner, const void* bytes, std::size_t count) {
+            SharedBytes out;
+            out.data = std::shared_ptr<const std::uint8_t>(std::move(owner),
+                                                           static_cast<const std::uint8_t*>(bytes));
+            out.size = count;
+            return out;
+        }
+
+        static SharedBytes adopt(std::string&& bytes) {
+            auto holder = std::make_shared<std::string>(std::move(bytes));
+            const std::string& stored = *holder;
+            return view(std::move(holder), stored.data(), stored.size());
+        }
+
+        static SharedBytes copy(const void* bytes, std::size_t count) {
+            return adopt(std::string(static_cast<const char*>(bytes), count));
+        }
+
+        SharedBytes slice(std::size_t offset, std::size_t count) const {
+            if (offset > size) {
+                return {};
+            }
+            count = std::min(count, size - offset);
+            return view(data, data.get() + offset, count);
+        }
+    };
+
     struct JobRequest {
         uint64_t id;
         std::string kind;
         std::string payload;
         JobOwner owner { JobOwner::Engine };
+        JobPriority priority { JobPriority::Normal };
+        uint64_t parent { 0 };
+        SharedBytes bytes;
+        int aux_a { 0 };
+        int aux_b { 0 };
+        int aux_c { 0 };
+        int aux_d { 0 };
+    };
+
+    // A job submitted with a parent keeps that parent from completing until the
+    // child itself has completed. Children are usually submitted from inside the
+    // parent's handler (see current_job()). bytes and aux_* are passed through to
+    // the JobRequest untouched, mirroring the payload/aux fields on JobResult.
+    // A non-zero timeout drops the job if it has not started by then; tag groups
+    // jobs for cancel_tag().
+    struct SubmitOptions {
+        JobPriority priority { JobPriority::Normal };
+        uint64_t parent { 0 };
+        std::string tag;
+        std::chrono::milliseconds timeout { 0 };
+        SharedBytes bytes;
+        int aux_a { 0 };
+        int aux_b { 0 };
+        int aux_c { 0 };
+        int aux_d { 0 };
     };
 
     struct NativePayload {
@@ -71,40 +147,163 @@ public:
         int aux_c { 0 };
         int aux_d { 0 };
         JobOwner owner { JobOwner::Engine };
+        bool cancelled { false };
     };
 
     using JobHandler = std::function<JobResult(const JobRequest&)>;
 
+    // Kind names are interned once; hot callers can cache the id and poll by it.
+    using KindId = uint32_t;
+    static constexpr KindId kInvalidKind = static_cast<KindId>(-1);
+
+    struct KindStats {
+        std::string kind;
+        uint64_t submitted { 0 };
+        uint64_t queued { 0 };
+        uint64_t running { 0 };
+        uint64_t completed { 0 };
+        uint64_t failed { 0 };
+        uint64_t cancelled { 0 };
+        uint64_t ready { 0 };
+        double avg_latency_ms { 0.0 };
+        double max_latency_ms { 0.0 };
+    };
+
     explicit JobSystem(std::size_t threadCount = 0);
     ~JobSystem();
 
     JobSystem(const JobSystem&) = delete;
     JobSystem& operator=(const JobSystem&) = delete;
 
-    uint64_t submit(const std::string& kind, const std::string& payload, JobOwner owner = JobOwner::Engine);
+    uint64_t submit(const std::string& kind, std::string payload, JobOwner owner = JobOwner::Engine);
+    uint64_t submit(const std::string& kind,
+                    std::string payload,
+                    JobOwner owner,
+                    const SubmitOptions& options);
     void register_handler(const std::string& kind, JobHandler handler);
     std::vector<JobResult> poll(std::size_t maxResults = 0);
     std::vector<JobResult> poll_kind(const std::string& kind, std::size_t maxResults = 0);
     std::vector<JobResult> poll_owner(JobOwner owner, std::size_t maxResults = 0);
     std::vector<JobResult> poll_kind_owner(const std::string& kind, JobOwner owner, std::size_t maxResults = 0);
+    std::vector<JobResult> poll_kind(KindId kind, std::size_t maxResults = 0);
+    std::vector<JobResult> poll_kind_owner(KindId kind, JobOwner owner, std::size_t maxResults = 0);
+    KindId kind_id(const std::string& kind);
+    std::vector<KindStats> stats();
+    std::size_t worker_count() const;
     void shutdown();
 
+    // Cancellation only affects jobs that have not started yet. A cancelled job
+    // still completes, with ok = false and cancelled = true, so pending
+    // bookkeeping and callbacks are released through the normal poll path.
+    bool cancel(uint64_t id);
+    std::size_t cancel_tag(const std::string& tag);
+    std::size_t cancel_owner(JobOwner owner);
+
+    // Id of the job running on the calling thread, or 0 outside a handler.
+    static uint64_t current_job();
+
 private:
-    void worker_loop();
-    bool pop_job(JobRequest& out);
+    static constexpr std::size_t kOwnerCount = 2;
+
+    // Entries live in a deque so their addresses stay stable; jobs keep a raw
+    // pointer and update the counters without taking handlerMutex.
+    struct KindEntry {
+        KindId id { kInvalidKind };
+        std::string name;
+        std::shared_ptr<const JobHandler> handler;
+        std::atomic<uint64_t> submitted { 0 };
+        std::atomic<uint64_t> started { 0 };
+        std::atomic<uint64_t> completed { 0 };
+        std::atomic<uint64_t> failed { 0 };
+        std::atomic<uint64_t> cancelled { 0 };
+        std::atomic<uint64_t> totalLatencyUs { 0 };
+        std::atomic<uint64_t> maxLatencyUs { 0 };
+    };
+
+    struct CompletedEntry {
+        uint64_t sequence;
+        JobResult result;
+    };
+    using CompletedQueue = std::deque<CompletedEntry>;
+
+    enum JobState : int {
+        Queued,
+        Running,
+        Cancelled
+    };
+
+    struct Job {
+        JobRequest request;
+        KindEntry* kind { nullptr };
+        std::chrono::steady_clock::time_point submittedAt;
+        std::chrono::steady_clock::time_point deadline;
+        bool hasDeadline { false };
+        std::string tag;
+        std::atomic<int> state { Queued };
+        std::shared_ptr<const JobHandler> handler;
+        std::shared_ptr<Job> parent;
+        // One reference for the job's own handler plus one per live child.
+        std::atomic<uint32_t> pending { 1 };
+        JobResult result {};
+    };
+    using JobPtr = std::shared_ptr<Job>;
+
+    // Each worker owns one deque per priority. The owner drains from the front
+    // so bursts finish roughly in submission order; idle workers steal from the
+    // back of other workers' deques.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::array<std::deque<JobPtr>, kPriorityCount> deques;
+        std::array<std::atomic<std::size_t>, kPriorityCount> sizes {};
+    };
+
+    static constexpr std::size_t kLiveShardCount = 16;
+    struct LiveShard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, JobPtr> jobs;
+    };
+
+    void worker_loop(std::size_t index);
+    void enqueue(JobPtr job);
+    JobPtr take_job(std::size_t index);
+    JobPtr pop_local(std::size_t index, std::size_t priority);
+    JobPtr steal(std::size_t victim, std::size_t priority);
+    void run_job(const JobPtr& job);
+    bool cancel_job(const JobPtr& job, const char* reason);
+    template <typename Predicate>
+    std::size_t cancel_matching(Predicate predicate);
+    void finish_job(JobPtr job);
+    void publish(KindEntry& kind, JobResult&& result, std::chrono::steady_clock::time_point submittedAt);
+    KindEntry* find_kind(const std::string& kind);
+    KindEntry& intern_kind(const std::string& kind);
+    std::vector<JobResult> drain_merged(std::vector<CompletedQueue*>& sources, std::size_t maxResults);
+    LiveShard& live_shard(uint64_t id);
+    void track_live(const JobPtr& job);
+    void untrack_live(uint64_t id);
+    JobPtr find_live(uint64_t id);
 
     std::atomic<bool> stop { false };
     std::atomic<uint64_t> nextId { 1 };
 
-    std::mutex handlerMutex;
-    std::unordered_map<std::string, JobHandler> handlers;
+    std::shared_mutex handlerMutex;
+    std::unordered_map<std::string, KindId> kindIds;
+    std::deque<KindEntry> kinds;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<std::size_t> nextQueue { 0 };
+    std::atomic<std::size_t> queuedCount { 0 };
+    std::atomic<std::size_t> sleepingWorkers { 0 };
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
 
-    std::mutex queueMutex;
-    std::condition_variable queueCv;
-    std::queue<JobRequest> jobQueue;
+    std::array<LiveShard, kLiveShardCount> liveShards;
 
+    // Results are bucketed per kind and owner and stamped with a sequence so
+    // cross-bucket polls still return them in completion order.
     std::mutex completedMutex;
-    std::vector<JobResult> completed;
+    std::deque<std::array<CompletedQueue, kOwnerCount>> completed;
+    std::size_t completedCount { 0 };
+    uint64_t completedSequence { 0 };
 
     std::vector<std::thread> workers;
 };
@@ -61,6 +61,8 @@ sol::table create_force_layout_table(sol::state_view lua)
         "auto-center-within-bounds", sol::property(&ForceLayout::get_auto_center_within_bounds,
             &ForceLayout::set_auto_center_within_bounds),
         "node-count", sol::property(&ForceLayout::node_count),
+        "dimensions", sol::property(&ForceLayout::get_dimensions, &ForceLayout::set_dimensions),
+        "background", sol::property(&ForceLayout::get_background, &ForceLayout::set_background),
         "positions", sol::property([](ForceLayout& self) { return PositionsView{&self}; })
     );
 
@@ -112,6 +114,20 @@ sol::table create_force_layout_table(sol::state_view lua)
                                autoCenterWithinBounds);
         }
     ));
+    force_layout_table.set_function("benchmark", [](sol::this_state state, size_t nodeCount,
+                                                    sol::optional<int> dimensions,
+                                                    sol::optional<double> minSeconds) {
+        ForceLayoutBenchmark result = benchmark_force_layout(nodeCount, dimensions.value_or(2),
+                                                             minSeconds.value_or(1.0));
+        sol::state_view lua(state);
+        sol::table out = lua.create_table();
+        out["nodes"] = result.nodes;
+        out["edges"] = result.edges;
+        out["iterations"] = result.iterations;
+        out["seconds"] = result.seconds;
+        out["iterations-per-second"] = result.iterations_per_second;
+        return out;
+    });
     return force_layout_table;
 }
 
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -20,8 +21,77 @@ struct SubmitArgs {
     std::string kind;
     std::string payload;
     sol::optional<sol::function> callback;
+    JobSystem::SubmitOptions options;
 };
 
+JobSystem::JobPriority parse_priority(const sol::object& value)
+{
+    if (!value.valid() || value == sol::lua_nil) {
+        return JobSystem::JobPriority::Normal;
+    }
+    if (!value.is<std::string>()) {
+        throw sol::error("jobs.submit priority must be a string");
+    }
+    std::string name = value.as<std::string>();
+    if (name == "interactive") {
+        return JobSystem::JobPriority::Interactive;
+    }
+    if (name == "normal") {
+        return JobSystem::JobPriority::Normal;
+    }
+    if (name == "background") {
+        return JobSystem::JobPriority::Background;
+    }
+    throw sol::error("jobs.submit priority must be one of interactive, normal, background");
+}
+
+JobSystem::SharedBytes parse_bytes(const sol::object& value)
+{
+    if (!value.valid() || value == sol::lua_nil) {
+        return {};
+    }
+    if (value.is<JobSystem::SharedBytes>()) {
+        return value.as<JobSystem::SharedBytes>();
+    }
+    if (value.is<std::string>()) {
+        return JobSystem::SharedBytes::adopt(value.as<std::string>());
+    }
+    throw sol::error("jobs.submit bytes must be a jobs.Bytes or a string");
+}
+
+int parse_aux(const sol::table& opts, const char* key)
+{
+    sol::object value = opts.get<sol::object>(key);
+    if (!value.valid() || value == sol::lua_nil) {
+        return 0;
+    }
+    if (value.is<bool>()) {
+        return value.as<bool>() ? 1 : 0;
+    }
+    if (value.is<int>()) {
+        return value.as<int>();
+    }
+    throw sol::error(std::string("jobs.submit ") + key + " must be an integer");
+}
+
+uint64_t parse_parent(const sol::object& value)
+{
+    if (!value.valid() || value == sol::lua_nil) {
+        return 0;
+    }
+    if (value.is<uint64_t>()) {
+        return value.as<uint64_t>();
+    }
+    if (value.is<double>()) {
+        double asDouble = value.as<double>();
+        if (asDouble < 0.0) {
+            throw sol::error("jobs.submit parent must be a job id");
+        }
+        return static_cast<uint64_t>(asDouble);
+    }
+    throw sol::error("jobs.submit parent must be a job id");
+}
+
 SubmitArgs parse_submit(sol::variadic_args args) {
     if (args.size() == 0) {
         throw sol::error("jobs.submit requires a kind");
@@ -67,7 +137,34 @@ SubmitArgs parse_submit(sol::variadic_args args) {
         }
     }
 
-    return SubmitArgs { std::move(kind), std::move(payload), cb };
+    JobSystem::SubmitOptions options;
+    if (opts) {
+        options.priority = parse_priority(opts->get<sol::object>("priority"));
+        options.parent = parse_parent(opts->get<sol::object>("parent"));
+        options.bytes = parse_bytes(opts->get<sol::object>("bytes"));
+        sol::object tagObj = opts->get<sol::object>("tag");
+        if (tagObj.is<std::string>()) {
+            options.tag = tagObj.as<std::string>();
+        } else if (tagObj.valid() && tagObj != sol::lua_nil) {
+            throw sol::error("jobs.submit tag must be a string");
+        }
+        sol::object timeoutObj = opts->get<sol::object>("timeout-ms");
+        if (timeoutObj.is<double>()) {
+            double timeoutMs = timeoutObj.as<double>();
+            if (timeoutMs < 0.0) {
+                throw sol::error("jobs.submit timeout-ms must be non-negative");
+            }
+            options.timeout = std::chrono::milliseconds(static_cast<int64_t>(timeoutMs));
+        } else if (timeoutObj.valid() && timeoutObj != sol::lua_nil) {
+            throw sol::error("jobs.submit timeout-ms must be a number");
+        }
+        options.aux_a = parse_aux(*opts, "aux-a");
+        options.aux_b = parse_aux(*opts, "aux-b");
+        options.aux_c = parse_aux(*opts, "aux-c");
+        options.aux_d = parse_aux(*opts, "aux-d");
+    }
+
+    return SubmitArgs { std::move(kind), std::move(payload), cb, options };
 }
 
 std::optional<std::size_t> parse_max_results(sol::variadic_args args) {
@@ -151,9 +248,9 @@ void attach_payload(sol::state_view lua, sol::table& item, JobSystem::JobResult&
                     entry["image-uri"] = sol::lua_nil;
                 }
                 if (!batch.image_bytes.empty()) {
-                    entry["image-bytes"] = batch.image_bytes;
+                    entry["image-blob"] = batch.image_bytes;
                 } else {
-                    entry["image-bytes"] = sol::lua_nil;
+                    entry["image-blob"] = sol::lua_nil;
                 }
                 batches[batch_index++] = entry;
             }
@@ -231,6 +328,7 @@ void enqueue_job_callback(JobSystem::JobResult&& res) {
         item["id"] = payload->id;
         item["ok"] = payload->ok;
         item["kind"] = payload->kind;
+        item["cancelled"] = payload->cancelled;
         if (payload->ok) {
             item["result"] = payload->result;
             item["error"] = sol::lua_nil;
@@ -274,10 +372,27 @@ void lua_bind_jobs(sol::state& lua, sol::table& lua_space, JobSystem& jobs) {
     active_jobs = &jobs;
     sol::table jobTable = lua.create_table();
 
+    // Shared, immutable byte buffers. Passing one to jobs.submit {:bytes ...} or
+    // to the texture loaders shares the storage instead of copying it.
+    jobTable.new_usertype<JobSystem::SharedBytes>("Bytes",
+        sol::no_constructor,
+        "size", sol::property([](const JobSystem::SharedBytes& self) { return self.size; }),
+        "slice", [](const JobSystem::SharedBytes& self, std::size_t offset, std::size_t count) {
+            return self.slice(offset, count);
+        },
+        "to-string", [](const JobSystem::SharedBytes& self) {
+            return std::string(reinterpret_cast<const char*>(self.get()), self.size);
+        },
+        sol::meta_function::length, [](const JobSystem::SharedBytes& self) { return self.size; });
+    jobTable.set_function("bytes", [](const std::string& value) {
+        return JobSystem::SharedBytes::copy(value.data(), value.size());
+    });
+
     jobTable.set_function("submit",
                           [&lua, &jobs](sol::variadic_args args) {
                               SubmitArgs parsed = parse_submit(args);
-                              uint64_t id = jobs.submit(parsed.kind, parsed.payload, JobSystem::JobOwner::Lua);
+                              uint64_t id = jobs.submit(parsed.kind, std::move(parsed.payload),
+                                                        JobSystem::JobOwner::Lua, parsed.options);
                               if (parsed.callback) {
                                   uint64_t cb_id = lua_callbacks_register(parsed.callback.value());
                                   job_callbacks[id] = cb_id;
@@ -317,6 +432,7 @@ void lua_bind_jobs(sol::state& lua, sol::table& lua_space, JobSystem& jobs) {
                                           item["id"] = payload->id;
                                           item["ok"] = payload->ok;
                                           item["kind"] = payload->kind;
+                                          item["cancelled"] = payload->cancelled;
                                           if (payload->ok) {
                                               item["result"] = payload->result;
                                               item["error"] = sol::lua_nil;
@@ -332,6 +448,7 @@ void lua_bind_jobs(sol::state& lua, sol::table& lua_space, JobSystem& jobs) {
                                       item["id"] = res.id;
                                       item["ok"] = res.ok;
                                       item["kind"] = res.kind;
+                                      item["cancelled"] = res.cancelled;
                                       if (res.ok) {
                                           item["result"] = res.result;
                                           item["error"] = sol::lua_nil;
@@ -347,6 +464,29 @@ void lua_bind_jobs(sol::state& lua, sol::table& lua_space, JobSystem& jobs) {
                               return output;
                           });
 
+    jobTable.set_function("cancel", [&jobs](uint64_t id) { return jobs.cancel(id); });
+    jobTable.set_function("cancel-tag", [&jobs](const std::string& tag) { return jobs.cancel_tag(tag); });
+    jobTable.set_function("cancel-all", [&jobs]() { return jobs.cancel_owner(JobSystem::JobOwner::Lua); });
+
+    jobTable.set_function("stats",
+                          [&lua, &jobs]() {
+                              sol::table output = lua.create_table();
+                              for (const auto& stat : jobs.stats()) {
+                                  sol::table entry = lua.create_table();
+                                  entry["submitted"] = stat.submitted;
+                                  entry["queued"] = stat.queued;
+                                  entry["running"] = stat.running;
+                                  entry["completed"] = stat.completed;
+                                  entry["failed"] = stat.failed;
+                                  entry["cancelled"] = stat.cancelled;
+                                  entry["ready"] = stat.ready;
+                                  entry["avg-latency-ms"] = stat.avg_latency_ms;
+                                  entry["max-latency-ms"] = stat.max_latency_ms;
+                                  output[stat.kind] = entry;
+                              }
+                              return output;
+                          });
+
     lua_space["jobs"] = jobTable;
 
     sol::table package = lua["package"];
@@ -308,6 +308,32 @@ sol::table create_gl_table(sol::state_view lua)
                                 static_cast<GLsizeiptr>(size_bytes),
                                 ptr);
             });
+    // Uploads only what changed. capacity_bytes is the size of the GL store from
+    // the previous call (0 for a fresh buffer); when the VectorBuffer has
+    // outgrown it the store is orphaned and respecified at the full capacity,
+    // otherwise each dirty range is written in place. Returns the new size.
+    gl.set_function("uploadVectorBuffer",
+            [](VectorBuffer& buffer, GLenum target, GLenum usage, size_t capacity_bytes) {
+                const size_t needed = buffer.capacity() * sizeof(float);
+                const size_t used = buffer.used_size();
+                const float* data = buffer.raw_data();
+                if (needed > capacity_bytes) {
+                    glBufferData(target, static_cast<GLsizeiptr>(needed), nullptr, usage);
+                    if (used > 0) {
+                        glBufferSubData(target, 0, static_cast<GLsizeiptr>(used), data);
+                    }
+                    buffer.clearDirty();
+                    return needed;
+                }
+                for (const auto& [from, to] : buffer.dirty_ranges()) {
+                    glBufferSubData(target,
+                                    static_cast<GLintptr>(from * sizeof(float)),
+                                    static_cast<GLsizeiptr>((to - from) * sizeof(float)),
+                                    data + from);
+                }
+                buffer.clearDirty();
+                return capacity_bytes;
+            });
     gl.set_function("glBlitFramebuffer", [](GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
                 GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
         glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
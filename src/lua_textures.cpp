@@ -4,6 +4,7 @@
 #include <optional>
 #include <sol/sol.hpp>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <stdexcept>
 
@@ -16,12 +17,42 @@ Texture2D& lua_load_texture(const std::string& name, const std::string& file) {
     return ResourceManager::loadTextureFromFile(name, file);
 }
 
-Texture2D& lua_load_texture_from_bytes(const std::string& name, const std::string& bytes, bool already_flipped = false) {
+namespace {
+
+// Encoded image bytes arrive either as a Lua string or as a shared jobs.Bytes
+// buffer; the latter is handed to the decoder without copying.
+JobSystem::SharedBytes shared_texture_bytes(const sol::object& bytes, const char* label)
+{
+    if (bytes.is<JobSystem::SharedBytes>()) {
+        return bytes.as<JobSystem::SharedBytes>();
+    }
+    if (bytes.is<std::string_view>()) {
+        std::string_view view = bytes.as<std::string_view>();
+        return JobSystem::SharedBytes::copy(view.data(), view.size());
+    }
+    throw std::runtime_error(std::string(label) + " expects a string or jobs.Bytes");
+}
+
+} // namespace
+
+Texture2D& lua_load_texture_from_bytes(const std::string& name, sol::object bytes, bool already_flipped = false) {
     int width = 0;
     int height = 0;
     int channels = 0;
-    const auto* data_ptr = reinterpret_cast<const std::uint8_t*>(bytes.data());
-    const std::size_t data_size = bytes.size();
+    const std::uint8_t* data_ptr = nullptr;
+    std::size_t data_size = 0;
+    JobSystem::SharedBytes shared;
+    if (bytes.is<JobSystem::SharedBytes>()) {
+        shared = bytes.as<JobSystem::SharedBytes>();
+        data_ptr = shared.get();
+        data_size = shared.size;
+    } else if (bytes.is<std::string_view>()) {
+        std::string_view view = bytes.as<std::string_view>();
+        data_ptr = reinterpret_cast<const std::uint8_t*>(view.data());
+        data_size = view.size();
+    } else {
+        throw std::runtime_error("textures.load-texture-from-bytes expects a string or jobs.Bytes");
+    }
     ImageBuffer image;
     std::string error;
     if (!load_image_memory(data_ptr, data_size, image, error)) {
@@ -68,7 +99,7 @@ Texture2D& lua_load_texture_from_pixels(const std::string& name,
 }
 
 Texture2D& lua_load_texture_from_bytes_async(const std::string& name,
-                                             const std::string& bytes,
+                                             const sol::object& bytes,
                                              bool already_flipped = false,
                                              sol::object cb = sol::lua_nil) {
     std::optional<uint64_t> cb_id;
@@ -81,27 +112,30 @@ Texture2D& lua_load_texture_from_bytes_async(const std::string& name,
             lua_callbacks_enqueue_value(cb_id.value(), sol::lua_nil);
         }
     };
-    return ResourceManager::loadTextureFromBytesAsync(name, bytes, already_flipped, std::move(onReady));
+    return ResourceManager::loadTextureFromBytesAsync(name,
+                                                      shared_texture_bytes(bytes, "textures.load-texture-from-bytes-async"),
+                                                      already_flipped,
+                                                      std::move(onReady));
 }
 
-Texture2D& lua_load_texture_from_bytes_async_simple(const std::string& name, const std::string& bytes) {
+Texture2D& lua_load_texture_from_bytes_async_simple(const std::string& name, sol::object bytes) {
     return lua_load_texture_from_bytes_async(name, bytes);
 }
 
 Texture2D& lua_load_texture_from_bytes_async_flipped(const std::string& name,
-                                                     const std::string& bytes,
+                                                     sol::object bytes,
                                                      bool already_flipped) {
     return lua_load_texture_from_bytes_async(name, bytes, already_flipped);
 }
 
 Texture2D& lua_load_texture_from_bytes_async_cb(const std::string& name,
-                                                const std::string& bytes,
+                                                sol::object bytes,
                                                 sol::function cb) {
     return lua_load_texture_from_bytes_async(name, bytes, false, cb);
 }
 
 Texture2D& lua_load_texture_from_bytes_async_flipped_cb(const std::string& name,
-                                                        const std::string& bytes,
+                                                        sol::object bytes,
                                                         bool already_flipped,
                                                         sol::function cb) {
     return lua_load_texture_from_bytes_async(name, bytes, already_flipped, cb);
@@ -189,6 +223,9 @@ sol::table create_textures_table(sol::state_view lua)
         &lua_load_texture_from_bytes_async_flipped_cb));
     textures_table.set_function("load-texture-from-pixels", &lua_load_texture_from_pixels);
     textures_table.set_function("get-texture", &lua_get_texture);
+    textures_table.set_function("cancel-load", [](const std::string& name) {
+        return ResourceManager::cancelTextureLoad(name);
+    });
     textures_table.set_function("load-cubemap", &lua_load_cubemap);
     textures_table.set_function("load-cubemap-async", &lua_load_cubemap_async);
     return textures_table;
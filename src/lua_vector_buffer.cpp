@@ -1,4 +1,5 @@
 #include <cstring>
+#include <limits>
 #include <sol/sol.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -14,6 +15,12 @@ sol::table create_vector_buffer_table(sol::state_view lua)
         "index", &VectorHandle::index,
         "size", &VectorHandle::size
     );
+    vector_buffer_table.new_usertype<VectorMove>("VectorMove",
+        sol::no_constructor,
+        "from", &VectorMove::from,
+        "to", &VectorMove::to,
+        "size", &VectorMove::size
+    );
 
     sol::usertype<VectorBuffer> vb_type = vector_buffer_table.new_usertype<VectorBuffer>("VectorBuffer",
         sol::no_constructor
@@ -25,6 +32,28 @@ sol::table create_vector_buffer_table(sol::state_view lua)
     vb_type.set_function("length", &VectorBuffer::length);
     vb_type.set_function("print", &VectorBuffer::print);
     vb_type.set_function("clear-dirty", &VectorBuffer::clearDirty);
+    vb_type.set_function("compact", [](VectorBuffer& self, sol::optional<size_t> max_floats) {
+        return sol::as_table(self.compact(max_floats.value_or(std::numeric_limits<size_t>::max())));
+    });
+    vb_type.set_function("relocate", [](VectorBuffer&, VectorHandle& handle,
+                                        sol::as_table_t<std::vector<VectorMove>> moves) {
+        return VectorBuffer::relocate(handle, moves.value());
+    });
+    vb_type.set_function("stats", [](sol::this_state state, VectorBuffer& self) {
+        sol::state_view lua(state);
+        VectorBufferStats stats = self.stats();
+        sol::table out = lua.create_table();
+        out["capacity"] = stats.capacity;
+        out["length"] = stats.length;
+        out["live"] = stats.live;
+        out["free"] = stats.free;
+        out["live-blocks"] = stats.live_blocks;
+        out["free-blocks"] = stats.free_blocks;
+        out["largest-free"] = stats.largest_free;
+        out["fragmentation"] = stats.fragmentation;
+        out["used-bytes"] = self.used_size();
+        return out;
+    });
     vb_type.set_function("dirty-range", [](sol::this_state state, VectorBuffer& self) -> sol::variadic_results {
         sol::variadic_results results;
         auto [from, to] = self.dirty_range();
@@ -35,6 +64,17 @@ sol::table create_vector_buffer_table(sol::state_view lua)
         results.push_back(sol::make_object(state, to));
         return results;
     });
+    vb_type.set_function("dirty-ranges", [](sol::this_state state, VectorBuffer& self) {
+        sol::state_view lua(state);
+        sol::table ranges = lua.create_table();
+        for (const auto& [from, to] : self.dirty_ranges()) {
+            ranges.add(lua.create_table_with("from", from, "to", to));
+        }
+        return ranges;
+    });
+    vb_type.set_function("dirty-merge-gap", &VectorBuffer::dirty_merge_gap);
+    vb_type.set_function("set-dirty-merge-gap", &VectorBuffer::setDirtyMergeGap);
+    vb_type.set_function("capacity", &VectorBuffer::capacity);
 
     auto validate_handle_range = [](VectorBuffer& self, const VectorHandle& handle, size_t offset, size_t count, const char* label) {
         if (handle.size == 0) {
@@ -151,6 +151,17 @@ void flip_vertical_buffer(std::uint8_t* data, int width, int height, int channel
     }
 }
 
+// Interned when the job system is attached so per-frame polls skip the
+// string lookup.
+struct ResourceJobKinds {
+    JobSystem::KindId loadTexture { JobSystem::kInvalidKind };
+    JobSystem::KindId decodeTextureBytes { JobSystem::kInvalidKind };
+    JobSystem::KindId loadCubemap { JobSystem::kInvalidKind };
+    JobSystem::KindId loadAudio { JobSystem::kInvalidKind };
+};
+
+ResourceJobKinds jobKinds;
+
 } // namespace
 
 // Provided by audio.cpp
@@ -254,6 +265,13 @@ TextureCubemap& ResourceManager::loadCubemapFromFiles(const std::string& name, c
 
 void ResourceManager::setJobSystem(JobSystem* system) {
     jobSystem = system;
+    jobKinds = ResourceJobKinds {};
+    if (jobSystem) {
+        jobKinds.loadTexture = jobSystem->kind_id("load_texture");
+        jobKinds.decodeTextureBytes = jobSystem->kind_id("decode_texture_bytes");
+        jobKinds.loadCubemap = jobSystem->kind_id("load_cubemap");
+        jobKinds.loadAudio = jobSystem->kind_id("load_audio");
+    }
 }
 
 void ResourceManager::setAudio(Audio* system) {
@@ -277,6 +295,16 @@ Texture2D& ResourceManager::loadTextureFromBytesAsync(const std::string& name,
                                                       const std::string& bytes,
                                                       bool alreadyFlipped,
                                                       ReadyCallback onReady) {
+    return loadTextureFromBytesAsync(name,
+                                     JobSystem::SharedBytes::copy(bytes.data(), bytes.size()),
+                                     alreadyFlipped,
+                                     std::move(onReady));
+}
+
+Texture2D& ResourceManager::loadTextureFromBytesAsync(const std::string& name,
+                                                      JobSystem::SharedBytes bytes,
+                                                      bool alreadyFlipped,
+                                                      ReadyCallback onReady) {
     if (!jobSystem) {
         throw std::runtime_error("Job system is not configured for ResourceManager");
     }
@@ -284,12 +312,10 @@ Texture2D& ResourceManager::loadTextureFromBytesAsync(const std::string& name,
     Texture2D& texture = textures[name];
     texture.ready = false;
 
-    std::string payload;
-    payload.reserve(bytes.size() + 1);
-    payload.push_back(alreadyFlipped ? static_cast<char>(1) : static_cast<char>(0));
-    payload.append(bytes);
-
-    uint64_t jobId = jobSystem->submit("decode_texture_bytes", payload);
+    JobSystem::SubmitOptions options;
+    options.bytes = std::move(bytes);
+    options.aux_a = alreadyFlipped ? 1 : 0;
+    uint64_t jobId = jobSystem->submit("decode_texture_bytes", std::string(), JobSystem::JobOwner::Engine, options);
     pendingTextureBytes[jobId] = PendingTextureBytes { name, std::move(onReady) };
     return texture;
 }
@@ -324,6 +350,30 @@ bool ResourceManager::loadAudioAsync(const std::string& name, const std::string&
     return true;
 }
 
+std::size_t ResourceManager::cancelTextureLoad(const std::string& name) {
+    if (!jobSystem) {
+        return 0;
+    }
+
+    // Pending entries are released when the cancelled results are polled.
+    std::size_t cancelled = 0;
+    for (const auto& entry : pendingTextures) {
+        if (entry.second.name == name && jobSystem->cancel(entry.first)) {
+            cancelled++;
+        }
+    }
+    for (const auto& entry : pendingTextureBytes) {
+        if (entry.second.name == name && jobSystem->cancel(entry.first)) {
+            cancelled++;
+        }
+    }
+    auto upload = std::remove_if(pendingTextureUploads.begin(), pendingTextureUploads.end(),
+                                 [&name](const PendingTextureUpload& pending) { return pending.name == name; });
+    cancelled += static_cast<std::size_t>(std::distance(upload, pendingTextureUploads.end()));
+    pendingTextureUploads.erase(upload, pendingTextureUploads.end());
+    return cancelled;
+}
+
 std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
     if (!jobSystem) {
         return 0;
@@ -335,7 +385,7 @@ std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
     const std::size_t uploadCubemapBudget = 1;
     const int uploadFacesPerCubemap = 1;
     std::vector<JobSystem::JobResult> results =
-        jobSystem->poll_kind_owner("load_texture", JobSystem::JobOwner::Engine, maxResults);
+        jobSystem->poll_kind_owner(jobKinds.loadTexture, JobSystem::JobOwner::Engine, maxResults);
     std::size_t applied = 0;
 
     for (auto& res : results) {
@@ -348,6 +398,9 @@ std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
         PendingTexture pending = std::move(it->second);
         pendingTextures.erase(it);
 
+        if (res.cancelled) {
+            continue;
+        }
         if (!res.ok) {
             LOG(Error) << "Failed to load texture '" << pending.name << "': " << res.error;
             continue;
@@ -377,7 +430,7 @@ std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
     std::size_t decodeMaxResults = maxResults == 0 ? decodeUploadBudget
                                                    : std::min(maxResults, decodeUploadBudget);
     std::vector<JobSystem::JobResult> decodeResults =
-        jobSystem->poll_kind_owner("decode_texture_bytes", JobSystem::JobOwner::Engine, decodeMaxResults);
+        jobSystem->poll_kind_owner(jobKinds.decodeTextureBytes, JobSystem::JobOwner::Engine, decodeMaxResults);
     for (auto& res : decodeResults) {
         auto it = pendingTextureBytes.find(res.id);
         if (it == pendingTextureBytes.end()) {
@@ -388,6 +441,9 @@ std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
         PendingTextureBytes pending = std::move(it->second);
         pendingTextureBytes.erase(it);
 
+        if (res.cancelled) {
+            continue;
+        }
         if (!res.ok) {
             LOG(Error) << "Failed to decode texture bytes for '" << pending.name << "': " << res.error;
             continue;
@@ -431,7 +487,7 @@ std::size_t ResourceManager::processTextureJobs(std::size_t maxResults) {
     }
 
     std::vector<JobSystem::JobResult> cubemapResults =
-        jobSystem->poll_kind_owner("load_cubemap", JobSystem::JobOwner::Engine, maxResults);
+        jobSystem->poll_kind_owner(jobKinds.loadCubemap, JobSystem::JobOwner::Engine, maxResults);
     for (auto& res : cubemapResults) {
         auto it = pendingCubemaps.find(res.id);
         if (it == pendingCubemaps.end()) {
@@ -498,7 +554,7 @@ std::size_t ResourceManager::processAudioJobs(std::size_t maxResults) {
     }
 
     std::vector<JobSystem::JobResult> results =
-        jobSystem->poll_kind_owner("load_audio", JobSystem::JobOwner::Engine, maxResults);
+        jobSystem->poll_kind_owner(jobKinds.loadAudio, JobSystem::JobOwner::Engine, maxResults);
     std::size_t applied = 0;
 
     for (auto& res : results) {
@@ -577,16 +633,25 @@ void register_texture_job_handlers(JobSystem& jobs) {
                               JobSystem::JobResult result {};
                               result.id = req.id;
                               result.kind = req.kind;
-                              if (req.payload.size() <= 1) {
+                              // Shared bytes carry the flip flag in aux_a; plain string payloads
+                              // keep the legacy leading flag byte.
+                              const std::uint8_t* data_ptr = nullptr;
+                              std::size_t data_size = 0;
+                              bool alreadyFlipped = false;
+                              if (!req.bytes.empty()) {
+                                  data_ptr = req.bytes.get();
+                                  data_size = req.bytes.size;
+                                  alreadyFlipped = req.aux_a != 0;
+                              } else if (req.payload.size() > 1) {
+                                  const auto* raw = reinterpret_cast<const std::uint8_t*>(req.payload.data());
+                                  alreadyFlipped = raw[0] != 0;
+                                  data_ptr = raw + 1;
+                                  data_size = req.payload.size() - 1;
+                              } else {
                                   result.ok = false;
                                   result.error = "No image bytes provided for texture decode";
                                   return result;
                               }
-
-                              const auto* raw = reinterpret_cast<const std::uint8_t*>(req.payload.data());
-                              bool alreadyFlipped = raw[0] != 0;
-                              const std::uint8_t* data_ptr = raw + 1;
-                              std::size_t data_size = req.payload.size() - 1;
                               int width = 0;
                               int height = 0;
                               int channels = 0;
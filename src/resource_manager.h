@@ -92,8 +92,13 @@ public:
     static Texture2D& loadTextureAsync(const std::string& name, const std::string& file, ReadyCallback onReady = {});
     static Texture2D& loadTextureFromBytesAsync(const std::string& name, const std::string& bytes, bool alreadyFlipped,
                                                 ReadyCallback onReady = {});
+    static Texture2D& loadTextureFromBytesAsync(const std::string& name, JobSystem::SharedBytes bytes,
+                                                bool alreadyFlipped, ReadyCallback onReady = {});
     static TextureCubemap& loadCubemapAsync(const std::string& name, const std::vector<std::string>& files, ReadyCallback onReady = {});
     static bool loadAudioAsync(const std::string& name, const std::string& file, ReadyCallback onReady = {});
+    // Cancels queued decodes and pending uploads for a texture whose consumer
+    // went away. Returns the number of jobs or uploads dropped.
+    static std::size_t cancelTextureLoad(const std::string& name);
     static std::size_t processTextureJobs(std::size_t maxResults = 0);
     static std::size_t processAudioJobs(std::size_t maxResults = 0);
     static void clearPending();
@@ -1 +1,273 @@
 #include "vector_buffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+size_t VectorBuffer::sizeClass(size_t size) {
+    size_t cls = 0;
+    while (size > 1 && cls + 1 < kSizeClassCount) {
+        size >>= 1;
+        ++cls;
+    }
+    return cls;
+}
+
+bool VectorBuffer::takeFree(size_t size, size_t& index) {
+    for (size_t cls = sizeClass(size); cls < kSizeClassCount; ++cls) {
+        auto& bucket = freeClasses[cls];
+        auto fit = bucket.lower_bound({ size, 0 });
+        if (fit == bucket.end()) {
+            continue;
+        }
+        index = fit->second;
+        const size_t blockSize = fit->first;
+        eraseFree(freeBlocks.find(index));
+        if (blockSize > size) {
+            insertFree(index + size, blockSize - size);
+        }
+        return true;
+    }
+    return false;
+}
+
+void VectorBuffer::eraseFree(std::map<size_t, size_t>::iterator it) {
+    freeClasses[sizeClass(it->second)].erase({ it->second, it->first });
+    freeBlocks.erase(it);
+}
+
+void VectorBuffer::insertFree(size_t index, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    auto next = freeBlocks.lower_bound(index);
+    if (next != freeBlocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == index) {
+            index = prev->first;
+            size += prev->second;
+            eraseFree(prev);
+        }
+    }
+    if (next != freeBlocks.end() && index + size == next->first) {
+        size += next->second;
+        eraseFree(next);
+    }
+
+    if (index + size == freeFrom) {
+        // Trailing free space is given back so uploads stop at the last live block.
+        freeFrom = index;
+        while (!dirtyRanges.empty() && dirtyRanges.back().first >= freeFrom) {
+            dirtyRanges.pop_back();
+        }
+        if (!dirtyRanges.empty() && dirtyRanges.back().second > freeFrom) {
+            dirtyRanges.back().second = freeFrom;
+        }
+        return;
+    }
+    freeBlocks.emplace(index, size);
+    freeClasses[sizeClass(size)].insert({ size, index });
+}
+
+void VectorBuffer::reserveTail(size_t size) {
+    const size_t required = freeFrom + size;
+    if (required <= buffer.size()) {
+        return;
+    }
+    resizeBuffer(std::max(required, buffer.size() + buffer.size() / 2));
+}
+
+void VectorBuffer::extendTail(size_t size) {
+    reserveTail(size);
+    const size_t start = freeFrom;
+    freeFrom += size;
+    // The GPU copy may still hold data from before the tail was trimmed.
+    markDirty(start, size);
+}
+
+void VectorBuffer::markDirty(size_t start, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (start >= freeFrom) {
+        return;
+    }
+    size_t end = start + size;
+    if (end > freeFrom) {
+        end = freeFrom;
+    }
+
+    const size_t gap = dirtyMergeGap;
+    auto first = std::lower_bound(dirtyRanges.begin(), dirtyRanges.end(), start,
+        [gap](const std::pair<size_t, size_t>& range, size_t value) {
+            return value > range.second && value - range.second > gap;
+        });
+    auto last = first;
+    while (last != dirtyRanges.end() && (last->first <= end || last->first - end <= gap)) {
+        start = std::min(start, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+    first = dirtyRanges.erase(first, last);
+    dirtyRanges.insert(first, { start, end });
+
+    if (dirtyRanges.size() > kMaxDirtyRanges) {
+        mergeClosestDirtyRanges();
+    }
+}
+
+void VectorBuffer::mergeClosestDirtyRanges() {
+    size_t best = 0;
+    size_t bestGap = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i + 1 < dirtyRanges.size(); ++i) {
+        const size_t gap = dirtyRanges[i + 1].first - dirtyRanges[i].second;
+        if (gap < bestGap) {
+            bestGap = gap;
+            best = i;
+        }
+    }
+    dirtyRanges[best].second = dirtyRanges[best + 1].second;
+    dirtyRanges.erase(dirtyRanges.begin() + static_cast<std::ptrdiff_t>(best) + 1);
+}
+
+VectorHandle VectorBuffer::allocate(size_t size) {
+    if (size == 0) {
+        return VectorHandle(freeFrom, 0);
+    }
+
+    size_t index = 0;
+    if (!takeFree(size, index)) {
+        index = freeFrom;
+        extendTail(size);
+    }
+    liveBlocks.emplace(index, size);
+    liveFloats += size;
+    return VectorHandle(index, size);
+}
+
+void VectorBuffer::reallocate(VectorHandle& handle, size_t newSize) {
+    if (newSize == handle.size) return;
+
+    auto live = liveBlocks.find(handle.index);
+    if (handle.size == 0 || live == liveBlocks.end() || live->second != handle.size) {
+        handle = allocate(newSize);
+        return;
+    }
+
+    if (newSize == 0) {
+        deleteHandle(handle);
+        handle.size = 0;
+        return;
+    }
+
+    if (newSize < handle.size) {
+        // Shrinking in-place: zero and release the tail
+        const size_t tail = handle.index + newSize;
+        const size_t released = handle.size - newSize;
+        zeroRegion(tail, released);
+        live->second = newSize;
+        liveFloats -= released;
+        handle.size = newSize;
+        insertFree(tail, released);
+        return;
+    }
+
+    const size_t extra = newSize - handle.size;
+    const size_t end = handle.index + handle.size;
+    if (end == freeFrom) {
+        extendTail(extra);
+        live->second = newSize;
+        liveFloats += extra;
+        handle.size = newSize;
+        return;
+    }
+    auto next = freeBlocks.find(end);
+    if (next != freeBlocks.end() && next->second >= extra) {
+        const size_t rest = next->second - extra;
+        eraseFree(next);
+        insertFree(end + extra, rest);
+        live->second = newSize;
+        liveFloats += extra;
+        handle.size = newSize;
+        return;
+    }
+
+    VectorHandle moved = allocate(newSize);
+    std::copy(buffer.begin() + handle.index,
+              buffer.begin() + handle.index + handle.size,
+              buffer.begin() + moved.index);
+    markDirty(moved.index, handle.size);
+    deleteHandle(handle);
+    handle = moved;
+}
+
+void VectorBuffer::deleteHandle(const VectorHandle& handle) {
+    if (handle.size == 0) {
+        return;
+    }
+    auto live = liveBlocks.find(handle.index);
+    if (live == liveBlocks.end() || live->second != handle.size) {
+        return;
+    }
+    liveBlocks.erase(live);
+    liveFloats -= handle.size;
+    zeroRegion(handle.index, handle.size);
+    insertFree(handle.index, handle.size);
+}
+
+std::vector<VectorMove> VectorBuffer::compact(size_t maxFloats) {
+    std::vector<VectorMove> moves;
+    size_t moved = 0;
+    while (!freeBlocks.empty() && moved < maxFloats) {
+        auto gap = freeBlocks.begin();
+        const size_t gapIndex = gap->first;
+        const size_t gapSize = gap->second;
+        // Free blocks are coalesced and the tail is trimmed, so a live block
+        // always follows a gap.
+        auto live = liveBlocks.find(gapIndex + gapSize);
+        if (live == liveBlocks.end()) {
+            throw std::runtime_error("VectorBuffer.compact found a gap without a following block");
+        }
+        const size_t from = live->first;
+        const size_t size = live->second;
+
+        eraseFree(gap);
+        std::memmove(&buffer[gapIndex], &buffer[from], size * sizeof(float));
+        liveBlocks.erase(live);
+        liveBlocks.emplace(gapIndex, size);
+        markDirty(gapIndex, size);
+        zeroRegion(gapIndex + size, gapSize);
+        insertFree(gapIndex + size, gapSize);
+
+        moves.push_back({ from, gapIndex, size });
+        moved += size;
+    }
+    return moves;
+}
+
+bool VectorBuffer::relocate(VectorHandle& handle, const std::vector<VectorMove>& moves) {
+    bool changed = false;
+    for (const VectorMove& move : moves) {
+        if (handle.size == move.size && handle.index == move.from) {
+            handle.index = move.to;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+VectorBufferStats VectorBuffer::stats() const {
+    VectorBufferStats out;
+    out.capacity = buffer.size();
+    out.length = freeFrom;
+    out.live = liveFloats;
+    out.live_blocks = liveBlocks.size();
+    out.free_blocks = freeBlocks.size();
+    for (const auto& [index, size] : freeBlocks) {
+        out.free += size;
+        out.largest_free = std::max(out.largest_free, size);
+    }
+    if (out.free > 0) {
+        out.fragmentation = 1.0 - static_cast<double>(out.largest_free) / static_cast<double>(out.free);
+    }
+    return out;
+}
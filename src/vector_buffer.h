@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
 #include <vector>
-#include <unordered_map>
-#include <list>
+#include <map>
+#include <set>
 #include <stdexcept>
 #include <utility>
+#include <limits>
 #include <cstring>  // for std::memset
 #include <iostream> // for std::cout
 #include <iomanip>  // for std::setprecision
@@ -18,6 +20,30 @@ public:
         : index(i), size(s) {}
 };
 
+// A live block relocated by VectorBuffer::compact, in floats.
+struct VectorMove {
+    size_t from;
+    size_t to;
+    size_t size;
+};
+
+struct VectorBufferStats {
+    size_t capacity = 0;     // floats reserved in the backing vector
+    size_t length = 0;       // floats up to the end of the last live block
+    size_t live = 0;         // floats owned by live handles
+    size_t free = 0;         // floats in free blocks below length
+    size_t live_blocks = 0;
+    size_t free_blocks = 0;
+    size_t largest_free = 0;
+    double fragmentation = 0.0; // 1 - largest_free / free
+};
+
+// Float sub-allocator backing the renderers' VBOs.
+//
+// Free blocks are coalesced with their neighbours and kept in power-of-two
+// size classes; free space at the tail is trimmed so length() (and therefore
+// every upload) only covers the range that still holds live data. Freed
+// regions are zeroed, which renders as degenerate geometry.
 class VectorBuffer {
 public:
     VectorBuffer(size_t initialSize = 1024) {
@@ -52,83 +78,63 @@ public:
         return freeFrom;
     }
 
+    size_t capacity() const {
+        return buffer.size();
+    }
+
     bool has_dirty() const {
-        return dirtyFrom != static_cast<size_t>(-1) && dirtyTo > dirtyFrom;
+        return !dirtyRanges.empty();
     }
 
+    // Bounding range of every dirty float.
     std::pair<size_t, size_t> dirty_range() const {
         if (!has_dirty()) {
             return { 0, 0 };
         }
-        return { dirtyFrom, dirtyTo };
+        return { dirtyRanges.front().first, dirtyRanges.back().second };
     }
 
-    void clearDirty() {
-        dirtyFrom = static_cast<size_t>(-1);
-        dirtyTo = 0;
+    // Sorted, disjoint [from, to) float ranges. Ranges closer than the merge
+    // gap are folded together, trading a few redundant bytes for fewer
+    // upload calls.
+    const std::vector<std::pair<size_t, size_t>>& dirty_ranges() const {
+        return dirtyRanges;
     }
 
-    void markDirty(size_t start, size_t size) {
-        if (size == 0) {
-            return;
-        }
-        if (start >= freeFrom) {
-            return;
-        }
-        size_t end = start + size;
-        if (end > freeFrom) {
-            end = freeFrom;
-        }
-        if (!has_dirty()) {
-            dirtyFrom = start;
-            dirtyTo = end;
-            return;
-        }
-        if (start < dirtyFrom) {
-            dirtyFrom = start;
-        }
-        if (end > dirtyTo) {
-            dirtyTo = end;
-        }
+    size_t dirty_merge_gap() const {
+        return dirtyMergeGap;
     }
 
-    VectorHandle allocate(size_t size) {
-        // Try reuse
-        auto& freedList = freed[size];
-        if (!freedList.empty()) {
-            VectorHandle handle = freedList.front();
-            freedList.pop_front();
-            return handle;
-        }
-
-        // Expand if needed
-        if (freeFrom + size > buffer.size()) {
-            resizeBuffer(2 * buffer.size() + size);
-        }
+    void setDirtyMergeGap(size_t floats) {
+        dirtyMergeGap = floats;
+    }
 
-        VectorHandle handle(freeFrom, size);
-        freeFrom += size;
-        return handle;
+    void clearDirty() {
+        dirtyRanges.clear();
     }
 
-    void reallocate(VectorHandle& handle, size_t newSize) {
-        if (newSize == handle.size) return;
+    void markDirty(size_t start, size_t size);
 
-        if (newSize < handle.size) {
-            // Shrinking in-place: zero extra bytes
-            zeroRegion(handle.index + newSize, handle.size - newSize);
-            handle.size = newSize;
-        } else {
-            // Allocate new region
-            deleteHandle(handle);
-            handle = allocate(newSize);
-        }
-    }
+    VectorHandle allocate(size_t size);
 
-    void deleteHandle(const VectorHandle& handle) {
-        zeroRegion(handle.index, handle.size);
-        freed[handle.size].push_back(handle);
-    }
+    // Resizes in place when the following block is free (or the handle ends
+    // the buffer); otherwise moves the contents to a new block.
+    void reallocate(VectorHandle& handle, size_t newSize);
+
+    // Deleting a handle that is not a live allocation (already deleted, or
+    // stale after a move) is a no-op.
+    void deleteHandle(const VectorHandle& handle);
+
+    // Slides live blocks down into the lowest free gaps until maxFloats
+    // floats have been moved or no gaps remain. Callers holding handles must
+    // apply the returned moves with relocate().
+    std::vector<VectorMove> compact(size_t maxFloats = std::numeric_limits<size_t>::max());
+
+    // Updates handle.index through moves returned by compact(); returns true
+    // if the handle moved.
+    static bool relocate(VectorHandle& handle, const std::vector<VectorMove>& moves);
+
+    VectorBufferStats stats() const;
 
     void print(const VectorHandle* handle = nullptr) const {
         std::cout << std::fixed << std::setprecision(4);
@@ -147,7 +153,7 @@ public:
                 std::cout << "  [" << i << "] = " << ptr[i] << '\n';
             }
         } else {
-            std::cout << "Full buffer (" << freeFrom << " / " 
+            std::cout << "Full buffer (" << freeFrom << " / "
                       << buffer.size() << " used):\n";
 
             for (size_t i = 0; i < freeFrom; ++i) {
@@ -157,11 +163,25 @@ public:
     }
 
 private:
+    static constexpr size_t kSizeClassCount = 48;
+    static constexpr size_t kMaxDirtyRanges = 32;
+
     std::vector<float> buffer;
     size_t freeFrom;
-    size_t dirtyFrom;
-    size_t dirtyTo;
-    std::unordered_map<size_t, std::list<VectorHandle>> freed;
+    std::vector<std::pair<size_t, size_t>> dirtyRanges;
+    size_t dirtyMergeGap = 256;
+    size_t liveFloats = 0;
+    std::map<size_t, size_t> liveBlocks;  // index -> size
+    std::map<size_t, size_t> freeBlocks;  // index -> size, coalesced
+    std::array<std::set<std::pair<size_t, size_t>>, kSizeClassCount> freeClasses; // (size, index)
+
+    static size_t sizeClass(size_t size);
+    bool takeFree(size_t size, size_t& index);
+    void insertFree(size_t index, size_t size);
+    void eraseFree(std::map<size_t, size_t>::iterator it);
+    void reserveTail(size_t size);
+    void extendTail(size_t size);
+    void mergeClosestDirtyRanges();
 
     void zeroRegion(size_t start, size_t size) {
         markDirty(start, size);